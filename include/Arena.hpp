@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator for objects that live as long as the arena. Memory comes in cache
+// line aligned blocks, so objects created after each other end up next to each other.
+// Objects are destroyed in reverse order when the arena is destroyed.
+class Arena
+{
+public:
+    constexpr static std::size_t CACHE_LINE = 64;
+
+    Arena(std::size_t blockSize = 64 * 1024) : m_BlockSize(blockSize) {}
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Construct an object in the arena, at least aligned to align
+    template<class Ty, class ...Args>
+    Ty* New(std::size_t align, Args&& ...args)
+    {
+        void* _memory = Allocate(sizeof(Ty), std::max(align, alignof(Ty)));
+        Ty* _object = new (_memory) Ty{ std::forward<Args>(args)... };
+        m_Destructors.push_back({ _object, [](void* o) { static_cast<Ty*>(o)->~Ty(); } });
+        return _object;
+    }
+
+    void* Allocate(std::size_t size, std::size_t align);
+
+    // Bytes handed out so far, including alignment padding
+    std::size_t Used() const { return m_Used; }
+
+    // Arena used by Current on this thread while the scope exists, so objects can put
+    // their members in the arena they're created in.
+    class Scope
+    {
+    public:
+        Scope(Arena& arena) : m_Previous(m_Current) { m_Current = &arena; }
+        ~Scope() { m_Current = m_Previous; }
+
+    private:
+        Arena* m_Previous;
+    };
+
+    // Arena of the innermost scope on this thread, nullptr outside of a scope
+    static Arena* Current() { return m_Current; }
+
+private:
+    struct Destructor
+    {
+        void* object;
+        void(*destroy)(void*);
+    };
+
+    std::size_t m_BlockSize;
+    std::vector<void*> m_Blocks;
+    std::vector<Destructor> m_Destructors;
+    std::byte* m_Next = nullptr;
+    std::byte* m_End = nullptr;
+    std::size_t m_Used = 0;
+
+    static inline thread_local Arena* m_Current = nullptr;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "pch.hpp"
+#include "Backend.hpp"
+
+// Wasapi device through Audijo, for the gui on windows, with a midi input
+// through Midijo.
+class AudijoBackend : public Backend
+{
+public:
+    AudijoBackend(const Settings& s);
+    ~AudijoBackend() override { Stop(); }
+
+    std::vector<Device> Devices() override;
+    std::vector<Device> MidiDevices() override;
+    bool Start(Engine& engine) override;
+    void Stop() override;
+    bool OpenMidi(const std::string& device) override;
+
+private:
+    Stream<Wasapi> m_Stream;
+    MidiIn<Windows> m_Midi;
+    Engine* m_Engine = nullptr;
+    std::vector<Sample> m_Block;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Engine.hpp"
+
+// Audio device that renders an engine on its own thread. Start prepares the engine
+// for the format the device was opened with, so the callbacks never allocate.
+class Backend
+{
+public:
+    constexpr static int DEFAULT_BUFFER_SIZE = 256; // Frames, for devices without a default
+
+    struct Settings
+    {
+        std::string device;        // Empty for the default device
+        double sampleRate = 48000;
+        int bufferSize = 0;        // Frames per callback, 0 for the default of the device
+        int periods = 2;           // Buffers queued in the device, the latency is bufferSize * periods
+        int channels = 2;
+        bool midi = true;          // Send the notes of the midi input of the backend to the engine
+        std::string midiDevice;    // Empty for the first midi input, see MidiDevices
+    } settings;
+
+    struct Device
+    {
+        std::string id;   // For Settings::device
+        std::string name;
+    };
+
+    Backend(const Settings& s) : settings(s) {}
+    virtual ~Backend() = default;
+
+    virtual std::vector<Device> Devices() { return {}; }
+
+    // Midi inputs to choose from. Backends with a port that other programs connect 
+    // to, like the alsa sequencer and jack, have none, their port opens with Start.
+    virtual std::vector<Device> MidiDevices() { return {}; }
+
+    // Switch to another midi input of MidiDevices, false when it can't be opened
+    virtual bool OpenMidi(const std::string&) { return false; }
+
+    // Open the device and start rendering, false when the device can't be opened
+    virtual bool Start(Engine& engine) = 0;
+    virtual void Stop() = 0;
+
+    // Format the device was opened with, can differ from the settings
+    const Settings& Format() const { return m_Format; }
+
+    // Buffers the device ran out of samples, since starting
+    std::uint64_t Xruns() const { return m_Xruns.load(std::memory_order_relaxed); }
+
+    // Names of the backends that were compiled in, the default first
+    static std::vector<std::string> Names();
+
+    // nullptr when the backend wasn't compiled in
+    static std::unique_ptr<Backend> Create(const std::string& name, const Settings& settings);
+
+protected:
+    Settings m_Format;
+    std::atomic<std::uint64_t> m_Xruns = 0;
+};
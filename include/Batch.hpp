@@ -0,0 +1,53 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Engine.hpp"
+#include "Render.hpp"
+
+// Renders many independent jobs in parallel, each on its own engine, streaming the
+// output to its own wav file. Jobs are taken from a thread pool sized to the cores,
+// one job per thread at a time. Wavetables and curve tables are shared by all engines,
+// every engine is prepared for the sample rate of its own job.
+class Batch
+{
+public:
+    struct Settings
+    {
+        Renderer::Settings render;
+        int threads = 0; // 0 for one per core
+    } settings;
+
+    struct Job
+    {
+        std::function<std::unique_ptr<Engine>()> engine{};
+        std::vector<NoteEvent> events{};
+        std::string midi{};   // Midi file rendered instead of the events, when set
+        std::string output{}; // Wav file, not written when empty
+        double sampleRate = 0;  // 0 for the sample rate of the settings
+    };
+
+    struct Result
+    {
+        std::int64_t frames = 0;
+        double sampleRate = 0; // Of the frames
+        double seconds = 0; // Time spent rendering
+        std::string error;  // Empty when the job succeeded
+    };
+
+    Batch() = default;
+    Batch(const Settings& s) : settings(s) {}
+
+    // Render all jobs and return when they're done, results in the order of the jobs
+    std::vector<Result> Run(std::span<const Job> jobs);
+
+    // Threads Run uses for a number of jobs with the current settings, never more
+    // threads than jobs
+    int Threads(std::size_t jobs) const;
+
+private:
+    Result m_Render(const Job& job);
+};
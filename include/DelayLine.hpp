@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+enum class Interpolation { None, Linear, Hermite, Allpass };
+
+// Ring buffer of interleaved frames for delay effects. The size is a power of two, so
+// positions wrap with a mask, and the frames of all channels are stored together so
+// a block is read or written in at most 2 copies.
+template<class Ty = float>
+class DelayLine
+{
+public:
+    // Allocate for delays up to maxDelay frames, clears the line
+    void Prepare(std::size_t maxDelay, int channels)
+    {
+        // Room for the taps of hermite interpolation
+        std::size_t _size = std::bit_ceil(maxDelay + 4);
+        m_Mask = _size - 1;
+        m_Channels = channels;
+        m_Data.assign(_size * channels, 0);
+        m_Allpass.assign(channels, 0);
+        m_Position = 0;
+    }
+
+    void Clear()
+    {
+        std::fill(m_Data.begin(), m_Data.end(), 0);
+        std::fill(m_Allpass.begin(), m_Allpass.end(), 0);
+    }
+
+    int Channels() const { return m_Channels; }
+
+    // Longest delay that can be read, in frames
+    std::size_t MaxDelay() const { return m_Data.empty() ? 0 : m_Mask - 3; }
+
+    // Move the write position to the next frames
+    void Advance(std::size_t frames = 1) { m_Position += frames; }
+
+    // Write and add at the write position, or the given number of frames before it
+    void Write(int channel, Ty s, std::size_t delay = 0) { At(channel, delay) = s; }
+    void Add(int channel, Ty s, std::size_t delay = 0) { At(channel, delay) += s; }
+
+    // Read a whole number of frames before the write position
+    Ty Read(int channel, std::size_t delay) const { return At(channel, delay); }
+
+    // Read a fractional number of frames before the write position. Hermite reads 1
+    // frame newer than the delay, so delays below 2 read frames that weren't written yet.
+    // Allpass keeps state per channel, and should be read once per frame with smooth delays.
+    template<Interpolation I = Interpolation::Linear>
+    Ty Read(int channel, double delay)
+    {
+        std::size_t _index = static_cast<std::size_t>(delay);
+        Ty _frac = static_cast<Ty>(delay - _index);
+        Ty _x0 = At(channel, _index);
+        Ty _x1 = At(channel, _index + 1);
+
+        if constexpr (I == Interpolation::None)
+            return _x0;
+        else if constexpr (I == Interpolation::Linear)
+            return _x0 + (_x1 - _x0) * _frac;
+        else if constexpr (I == Interpolation::Hermite)
+        {
+            Ty _xm1 = At(channel, _index - 1);
+            Ty _x2 = At(channel, _index + 2);
+            Ty _c1 = (_x1 - _xm1) * Ty(0.5);
+            Ty _c2 = _xm1 - Ty(2.5) * _x0 + Ty(2) * _x1 - Ty(0.5) * _x2;
+            Ty _c3 = Ty(0.5) * (_x2 - _xm1) + Ty(1.5) * (_x0 - _x1);
+            return ((_c3 * _frac + _c2) * _frac + _c1) * _frac + _x0;
+        }
+        else
+        {
+            Ty _a = (1 - _frac) / (1 + _frac);
+            Ty& _y = m_Allpass[channel];
+            return _y = _a * _x0 + _x1 - _a * _y;
+        }
+    }
+
+    // Write interleaved frames after the write position, and advance to the last one.
+    // Same as calling Advance and Write for every frame.
+    void Write(std::span<const Ty> frames)
+    {
+        std::size_t _frames = frames.size() / m_Channels;
+        Copy(m_Position + 1, _frames, [&](Ty* line, std::size_t offset, std::size_t size) {
+            std::copy_n(frames.data() + offset, size, line);
+        });
+        m_Position += _frames;
+    }
+
+    // Read the frames the next Write of a block reads with per frame Read calls, only
+    // frames that were already written when the delay is at least the block size.
+    void Read(std::span<Ty> frames, std::size_t delay) const
+    {
+        std::size_t _frames = frames.size() / m_Channels;
+        Copy(m_Position + 1 - delay, _frames, [&](const Ty* line, std::size_t offset, std::size_t size) {
+            std::copy_n(line, size, frames.data() + offset);
+        });
+    }
+
+private:
+    std::vector<Ty> m_Data;
+    std::vector<Ty> m_Allpass; // Last output of allpass reads per channel
+    std::size_t m_Mask = 0;
+    std::size_t m_Position = 0; // Wrapped when accessed
+    int m_Channels = 0;
+
+    Ty& At(int channel, std::size_t delay) { return m_Data[((m_Position - delay) & m_Mask) * m_Channels + channel]; }
+    const Ty& At(int channel, std::size_t delay) const { return m_Data[((m_Position - delay) & m_Mask) * m_Channels + channel]; }
+
+    // Call fun for the contiguous parts of frames starting at a position
+    template<class Fun>
+    void Copy(std::size_t position, std::size_t frames, Fun&& fun) const
+    {
+        std::size_t _start = position & m_Mask;
+        std::size_t _first = std::min(frames, m_Mask + 1 - _start);
+        Ty* _data = const_cast<Ty*>(m_Data.data());
+        fun(_data + _start * m_Channels, 0, _first * m_Channels);
+        if (_first < frames)
+            fun(_data, _first * m_Channels, (frames - _first) * m_Channels);
+    }
+};
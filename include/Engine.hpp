@@ -0,0 +1,340 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "Arena.hpp"
+#include "EventQueue.hpp"
+#include "Modules.hpp"
+#include "Monitor.hpp"
+#include "Param.hpp"
+#include "Realtime.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+#include "VoiceAllocator.hpp"
+
+// Voice and module engine of a synth, doesn't depend on a gui or an 
+// audio device so patches can also be rendered headless.
+struct Engine
+{
+    struct VoiceBase
+    {
+        virtual ~VoiceBase() = default;
+
+        virtual ChainFun Chain() = 0;
+        virtual void Mod() { };
+        virtual void NotePress(int note, int velocity) = 0;
+        virtual void NoteRelease(int note) = 0;
+        virtual bool Done() = 0;
+        virtual Sample Level() { return Done() ? 0 : 1; } // Current level, for voice stealing
+
+        // Modules are placed in the arena of the voice bank that creates the voice
+        template<std::derived_from<Module> Ty, class ...Args>
+        Ty& Add(Args&& ...args) { return m_Add<Ty>(std::forward<Args>(args)...); }
+
+        template<std::derived_from<Module> Ty>
+        Ty& Add(const typename Ty::Settings& settings) { return m_Add<Ty>(settings); }
+
+        // Mark a module that is only read by Mod, when processing blocks it is advanced
+        // once per control period instead of every sample. Other modules should be in the chain.
+        template<std::derived_from<Module> Ty>
+        Ty& Control(Ty& module)
+        {
+            m_Controls.push_back(&module);
+            return module;
+        }
+
+        void Init() { m_Chain = Chain(); }
+
+        // Allocate the output and prepare all modules, see Module::Prepare
+        virtual void Prepare(double sampleRate, int maxBlockSize, int channels);
+
+        // Render a block of interleaved frames into the output of the voice. Mod 
+        // is called once every Module::CONTROL_RATE frames.
+        virtual void Render(std::size_t samples, int channels);
+
+        // Output of the last render
+        std::span<const Sample> Output() const { return { m_Buffer.data(), m_Rendered }; }
+
+        // Sample rate the voice was prepared for
+        double SampleRate() const { return m_SampleRate; }
+
+        // Render the voice for a block of interleaved frames, adding to the block.
+        void Process(std::span<Sample> block, int channels);
+
+    protected:
+        template<class Chain>
+        void m_Render(std::size_t samples, int channels, Chain& chain)
+        {
+            Trace::Scope _trace{ "Voice" };
+            Realtime::Scope _realtime;
+
+            // The chain overwrites its input, so start from silence
+            assert(samples <= m_Buffer.size() && "Voice wasn't prepared for this block size");
+            std::fill_n(m_Buffer.begin(), samples, 0);
+            m_Rendered = samples;
+
+            std::size_t _frames = samples / channels;
+            std::size_t _rate = std::max(Module::CONTROL_RATE, 1);
+            for (std::size_t i = 0; i < _frames; i += _rate)
+            {
+                std::size_t _size = std::min(_rate, _frames - i);
+                for (auto& j : m_Controls)
+                    j->Advance(_size);
+
+                Mod();
+                chain(std::span<Sample>{ m_Buffer.data() + i * channels, _size * channels }, channels);
+            }
+        }
+
+    private:
+        ChainFun m_Chain;
+        std::vector<Module*> m_Modules;
+        std::vector<std::unique_ptr<Module>> m_Owned; // Modules of voices created outside of an arena
+        std::vector<Module*> m_Controls;
+        std::vector<Sample> m_Buffer;
+        std::size_t m_Rendered = 0;
+        double m_SampleRate = 44100;
+
+        template<class Ty, class ...Args>
+        Ty& m_Add(Args&& ...args)
+        {
+            Ty* _module;
+            if (Arena* _arena = Arena::Current())
+                _module = _arena->New<Ty>(alignof(Ty), std::forward<Args>(args)...);
+            else
+                _module = static_cast<Ty*>(m_Owned.emplace_back(new Ty{ std::forward<Args>(args)... }).get());
+
+            m_Modules.push_back(_module);
+            return *_module;
+        }
+
+        friend struct Engine;
+    };
+
+    template<class Parent>
+    struct Voice : VoiceBase
+    {
+        Voice(Engine* p) : synth(*dynamic_cast<Parent*>(p)) { }
+        Parent& synth;
+    };
+
+    // Voice with a chain type known at compile time. Self provides Pipeline(), returning
+    // the chain built with operator>>, so blocks call the stages directly instead of 
+    // through ChainFun and the compiler can inline the whole chain. The pipeline is 
+    // built once when preparing and kept in the voice, Self isn't complete yet where
+    // the members are declared, so it's stored in bytes of the voice.
+    template<class Parent, class Self>
+    struct StaticVoice : Voice<Parent>
+    {
+        constexpr static std::size_t PIPELINE_SIZE = 128; // Bytes
+
+        using Voice<Parent>::Voice;
+
+        ChainFun Chain() override { return static_cast<Self&>(*this).Pipeline(); }
+
+        void Prepare(double sampleRate, int maxBlockSize, int channels) override
+        {
+            Voice<Parent>::Prepare(sampleRate, maxBlockSize, channels);
+            if (m_Built)
+                return;
+
+            using Pipeline = decltype(std::declval<Self&>().Pipeline());
+            static_assert(sizeof(Pipeline) <= PIPELINE_SIZE, "Pipeline doesn't fit in the voice, increase PIPELINE_SIZE");
+            static_assert(alignof(Pipeline) <= alignof(std::max_align_t), "Pipeline is over-aligned");
+            static_assert(std::is_trivially_destructible_v<Pipeline>, "Pipeline stages are only references to modules");
+            new (m_Pipeline) Pipeline{ static_cast<Self&>(*this).Pipeline() };
+            m_Built = true;
+        }
+
+        void Render(std::size_t samples, int channels) override
+        {
+            using Pipeline = decltype(std::declval<Self&>().Pipeline());
+            assert(m_Built && "Voice wasn't prepared");
+            this->m_Render(samples, channels, *std::launder(reinterpret_cast<Pipeline*>(m_Pipeline)));
+        }
+
+    private:
+        alignas(std::max_align_t) std::byte m_Pipeline[PIPELINE_SIZE];
+        bool m_Built = false;
+    };
+
+    class VoiceBank
+    {
+    public:
+        template<class Ty>
+        void AddVoices(int voices, Engine* parent)
+        {
+            // Every voice starts on a cache line, followed by its modules
+            std::size_t _used = m_Arena.Used();
+            Arena::Scope _scope{ m_Arena };
+            m_Allocator.Voices(voices);
+            for (int i = 0; i < voices; i++)
+                m_GeneratorVoices.push_back(m_Arena.New<Ty>(Arena::CACHE_LINE, parent));
+            m_VoiceBytes = (m_Arena.Used() - _used) / std::max(voices, 1);
+
+            for (auto& i : m_GeneratorVoices)
+                i->Init();
+
+            // Voices added after preparing get the same format
+            if (m_Format.maxBlockSize)
+                for (auto& i : m_GeneratorVoices | std::views::drop(m_GeneratorVoices.size() - voices))
+                    i->Prepare(m_Format.sampleRate, m_Format.maxBlockSize, m_Format.channels);
+
+            m_Active.reserve(m_GeneratorVoices.size());
+        }
+
+        void Prepare(double sampleRate, int maxBlockSize, int channels);
+        void NotePress(int note, int velocity);
+        void NoteRelease(int note, int velocity);
+        void Process(std::span<Sample> block, int channels);
+        std::span<VoiceBase* const> Voices() const { return m_GeneratorVoices; }
+
+        // Voices rendered by the last call to Process
+        int Playing() const { return m_Playing; }
+
+        // Arena bytes of a voice and its modules, for the last added voices. Buffers 
+        // the modules allocate themselves, like delay lines, aren't included.
+        std::size_t VoiceBytes() const { return m_VoiceBytes; }
+
+        // Render voices on a pool of threads, 1 renders on the calling thread. The 
+        // voices are mixed in order, so the output is the same for any thread count.
+        // Blocks with fewer voices or frames than below render on the calling thread.
+        void Threads(int threads);
+
+        constexpr static std::size_t PARALLEL_VOICES = 4;
+        constexpr static std::size_t PARALLEL_FRAMES = 64;
+
+        // Voice to steal when all voices are playing
+        void Stealing(VoiceAllocator::Policy policy) { m_Allocator.settings.policy = policy; }
+
+    private:
+        struct Format
+        {
+            double sampleRate = 44100;
+            int maxBlockSize = 0; // 0 until prepared
+            int channels = 2;
+        };
+
+        Arena m_Arena; // Owns the voices, so it's destroyed last
+        std::vector<VoiceBase*> m_GeneratorVoices;
+        std::unique_ptr<ThreadPool> m_Pool;
+        std::vector<VoiceBase*> m_Active;
+        VoiceAllocator m_Allocator;
+        Format m_Format;
+        std::size_t m_VoiceBytes = 0;
+        int m_Playing = 0;
+
+        // Mark voices that went silent, so they're used before stealing
+        bool m_Done(std::size_t voice);
+    };
+
+    // Note event for the audio thread
+    struct Event
+    {
+        enum Type { Press, Release } type = Press;
+        int note = 60;
+        int velocity = 127;
+        std::int64_t frame = -1; // Engine frame, -1 for the moment it was sent
+    };
+
+    constexpr static std::size_t MAX_EVENTS = 1024;
+
+    Engine() { m_Pending.reserve(MAX_EVENTS); }
+    virtual ~Engine() = default;
+
+    template<class Ty>
+    void AddVoices(int count) { m_Voices.AddVoices<Ty>(count, this); }
+    std::size_t VoiceBytes() const { return m_Voices.VoiceBytes(); }
+    virtual ChainFun Chain() = 0;
+    virtual void Mod() { };
+
+    template<std::derived_from<Module> Ty, class ...Args>
+    Ty& Add(Args&& ...args)
+    {
+        return static_cast<Ty&>(*m_Modules.emplace_back(new Ty{ std::forward<Args>(args)... }));
+    }
+
+    template<std::derived_from<Module> Ty>
+    Ty& Add(const typename Ty::Settings& settings)
+    {
+        return static_cast<Ty&>(*m_Modules.emplace_back(new Ty{ settings }));
+    }
+
+    // Set the sample rate of the engine, its modules and voices, and allocate all 
+    // buffers for blocks of up to maxBlockSize frames. Call before processing, and 
+    // again from a non audio thread when the device changes, processing must be 
+    // stopped while preparing.
+    virtual void Prepare(double sampleRate, int maxBlockSize, int channels);
+
+    // Render voices on a pool of threads, see VoiceBank::Threads
+    void Threads(int threads) { m_Voices.Threads(threads); }
+
+    // Voice to steal when all voices are playing, see VoiceAllocator
+    virtual void Stealing(VoiceAllocator::Policy policy) { m_Voices.Stealing(policy); }
+
+    // Add a parameter that is smoothed once per block, before Mod
+    Param& AddParam(const Param::Settings& settings = {}) { return m_Params.emplace_back(settings); }
+
+    // Thread-safe, queue an event for the audio thread. Events without a frame are
+    // rendered one block after they were sent, so the time between events is kept
+    // to the sample. Returns false when the queue is full.
+    bool Send(Event e);
+
+    // Frames rendered so far
+    std::int64_t FramesRendered() const { return m_Frame; }
+
+    // Handle a note on the audio thread, other threads Send events instead.
+    virtual void NotePress(int note, int velocity) { m_Voices.NotePress(note, velocity); }
+    virtual void NoteRelease(int note, int velocity) { m_Voices.NoteRelease(note, velocity); }
+
+    // Render a block of interleaved frames, overwrites the contents of the block. 
+    // The block is split at queued events, so every event lands on its frame. Blocks
+    // larger than the prepared size are rendered in parts. The engine has to be 
+    // prepared for the channel count, otherwise the block is silent.
+    void Process(std::span<Sample> block, int channels);
+
+    // Latest performance counters of Process, for one reader thread at a time. See Monitor.
+    Monitor::Stats Stats() { return m_Monitor.Read(); }
+
+private:
+    // Start of the last block, written by the audio thread as a seqlock so
+    // other threads can stamp events with the current frame.
+    struct Clock
+    {
+        std::atomic<std::uint32_t> sequence = 0;
+        std::atomic<std::int64_t> frame = 0;
+        std::atomic<std::int64_t> time = 0; // nanoseconds, 0 before the first block
+        std::atomic<std::int64_t> latency = 0; // frames in the block
+        std::atomic<double> sampleRate = 44100;
+    };
+
+    ChainFun m_Chain;
+    std::list<std::unique_ptr<Module>> m_Modules;
+    std::list<Param> m_Params;
+    VoiceBank m_Voices;
+
+    EventQueue<Event, MAX_EVENTS> m_Events;
+    std::vector<Event> m_Pending; // Received events, latest first
+    std::int64_t m_Frame = 0;
+    Clock m_Clock;
+    double m_SampleRate = 44100;
+    int m_BlockSize = 0; // Prepared maximum, 0 until prepared
+    int m_Channels = 0;
+    Monitor m_Monitor;
+
+    std::int64_t m_Now() const;
+    void m_Publish(std::int64_t frames);
+    void m_Receive();
+    std::int64_t m_Dispatch(std::int64_t frame);
+    void m_Process(std::span<Sample> block, int channels);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue for any number of producers and a single consumer. Every
+// slot has a sequence number that tells whose turn it is, so producers only contend 
+// on the write index and the consumer never waits for a producer.
+template<class Ty, std::size_t Size>
+class EventQueue
+{
+    static_assert((Size & (Size - 1)) == 0, "Size must be a power of 2");
+
+public:
+    EventQueue()
+    {
+        for (std::size_t i = 0; i < Size; i++)
+            m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Thread-safe, returns false when the queue is full
+    bool Push(const Ty& value)
+    {
+        std::size_t _pos = m_Write.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& _slot = m_Slots[_pos & (Size - 1)];
+            std::size_t _sequence = _slot.sequence.load(std::memory_order_acquire);
+            auto _diff = static_cast<std::intptr_t>(_sequence) - static_cast<std::intptr_t>(_pos);
+            if (_diff == 0)
+            {
+                if (m_Write.compare_exchange_weak(_pos, _pos + 1, std::memory_order_relaxed))
+                {
+                    _slot.value = value;
+                    _slot.sequence.store(_pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (_diff < 0)
+                return false;
+            else
+                _pos = m_Write.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Only call from the consumer thread, returns false when the queue is empty
+    bool Pop(Ty& value)
+    {
+        Slot& _slot = m_Slots[m_Read & (Size - 1)];
+        if (_slot.sequence.load(std::memory_order_acquire) != m_Read + 1)
+            return false;
+
+        value = _slot.value;
+        _slot.sequence.store(m_Read + Size, std::memory_order_release);
+        m_Read++;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        Ty value;
+    };
+
+    std::array<Slot, Size> m_Slots;
+    alignas(64) std::atomic<std::size_t> m_Write = 0;
+    alignas(64) std::size_t m_Read = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <algorithm>
 #include <cmath>
+#include <span>
 #include <vector>
 
 #define constrain(x, y, z) (x < y ? y : x > z ? z : x)
@@ -10,14 +11,6 @@ enum class FilterType
     Off, LowPass, HighPass, BandPass, Notch, AllPass, PeakingEQ, LowShelf, HighShelf, ITEMS
 };
 
-template<typename T>
-class Filter
-{
-public:
-    using Params = T;
-    virtual float Apply(float s, Params& p) = 0;
-};
-
 class FilterParameters
 {
 public:
@@ -126,69 +119,102 @@ public:
     double w0 = 0, cosw0 = 0, sinw0 = 0, A = 0, alpha = 0;
 };
 
-template<typename P = BiquadParameters>
-class BiquadFilter : public Filter<P>
+// Transposed direct form II biquad, or a cascade of them, for any number of channels. 
+// Channels are processed in groups of Lanes in the same loop so they end up in simd
+// lanes, Ty is the precision of the coefficients and state.
+template<class Ty, std::size_t Sections = 1, std::size_t Lanes = 2>
+class Biquad
 {
 public:
-    float Apply(float s, P& p) override
+    struct Coefficients
     {
-        x[0] = s;
-        y[0] = p.b0a0 * x[0] + p.b1a0 * x[1] + p.b2a0 * x[2] - p.a1a0 * y[1] - p.a2a0 * y[2];
+        Ty b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0; // Over a0
+    } coefficients[Sections];
 
-        for (int i = sizeof(y) / sizeof(double) - 2; i >= 0; i--)
-            y[i + 1] = y[i];
+    Biquad() { Prepare(Lanes); }
 
-        for (int i = sizeof(x) / sizeof(double) - 2; i >= 0; i--)
-            x[i + 1] = x[i];
-
-        return y[0];
+    // Allocate the state for a number of channels, clears the state
+    void Prepare(int channels)
+    {
+        m_Channels = channels;
+        m_State.assign((channels + Lanes - 1) / Lanes * Sections, {});
     }
 
-private:
-    double y[3]{ 0, 0, 0 }, x[3]{ 0, 0, 0 };
-};
+    void Reset() { std::fill(m_State.begin(), m_State.end(), State{}); }
 
-template<size_t N, class F, class P = F::Params>
-class ChannelEqualizer
-{
-public:
-    ChannelEqualizer(std::vector<P>& a)
-        : m_Params(a), m_Filters()
-    {}
+    int Channels() const { return m_Channels; }
 
-    float Apply(float s)
+    void Set(const BiquadParameters& p, std::size_t section = 0)
     {
-        for (int i = 0; i < N; i++)
-            if (m_Params[i].type != FilterType::Off)
-                s = m_Filters[i].Apply(s, m_Params[i]);
-
-        return s;
+        coefficients[section] = { static_cast<Ty>(p.b0a0), static_cast<Ty>(p.b1a0), 
+            static_cast<Ty>(p.b2a0), static_cast<Ty>(p.a1a0), static_cast<Ty>(p.a2a0) };
     }
 
-    std::vector<P>& m_Params;
-    F m_Filters[N];
-};
-
-
-template<size_t N, class F, class P = F::Params>
-class StereoEqualizer
-{
-public:
-    StereoEqualizer(P& a)
-        : m_Params(a), m_Filters()
-    {}
+    // Filter a sample of a single channel
+    Ty Process(Ty x, int channel)
+    {
+        State* _state = &m_State[channel / Lanes * Sections];
+        std::size_t _lane = channel % Lanes;
+        for (std::size_t s = 0; s < Sections; s++)
+        {
+            const Coefficients& _c = coefficients[s];
+            Ty& _z1 = _state[s].z1[_lane];
+            Ty& _z2 = _state[s].z2[_lane];
+            Ty _y = _c.b0 * x + _z1;
+            _z1 = _c.b1 * x - _c.a1 * _y + _z2;
+            _z2 = _c.b2 * x - _c.a2 * _y;
+            x = _y;
+        }
+        return x;
+    }
 
-    float Apply(float s, int c)
+    // Filter a frame of interleaved channels, in place
+    template<class In>
+    void Process(In* frame)
     {
-        int channel = c % N;
-        if (m_Params.type != FilterType::Off)
-            s = m_Filters[channel].Apply(s, m_Params);
+        for (int g = 0; g < m_Channels; g += Lanes)
+        {
+            alignas(sizeof(Ty) * Lanes) Ty _x[Lanes]{};
+            std::size_t _count = std::min<std::size_t>(Lanes, m_Channels - g);
+            for (std::size_t l = 0; l < _count; l++)
+                _x[l] = frame[g + l];
+
+            State* _state = &m_State[g / Lanes * Sections];
+            for (std::size_t s = 0; s < Sections; s++)
+            {
+                const Coefficients _c = coefficients[s];
+                State& _z = _state[s];
+                for (std::size_t l = 0; l < Lanes; l++)
+                {
+                    Ty _y = _c.b0 * _x[l] + _z.z1[l];
+                    _z.z1[l] = _c.b1 * _x[l] - _c.a1 * _y + _z.z2[l];
+                    _z.z2[l] = _c.b2 * _x[l] - _c.a2 * _y;
+                    _x[l] = _y;
+                }
+            }
+
+            for (std::size_t l = 0; l < _count; l++)
+                frame[g + l] = _x[l];
+        }
+    }
 
-        return s;
+    // Filter a block of interleaved frames with the prepared channel count, in place
+    template<class In>
+    void Process(std::span<In> block)
+    {
+        for (std::size_t i = 0; i < block.size(); i += m_Channels)
+            Process(block.data() + i);
     }
 
-    P& m_Params;
-    F m_Filters[N];
+private:
+    struct alignas(sizeof(Ty) * Lanes) State
+    {
+        Ty z1[Lanes]{};
+        Ty z2[Lanes]{};
+    };
+
+    std::vector<State> m_State; // Sections per group of lanes
+    int m_Channels = 0;
 };
 
 // Simple low/high pass band filter
@@ -0,0 +1,103 @@
+#pragma once
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include "Modules.hpp"
+
+// Routing graph of chain stages with splits, sums and sends, processed as a module so
+// it can be part of a chain. Every node sums its inputs, each with a gain, and runs
+// the sum through its stage: a module or a chain built with operator>>. Prepare sorts
+// the nodes that reach the output and gives every node a buffer that is reused once
+// the last node reading it ran, so wide graphs only need a few scratch buffers.
+//
+//     auto _in = graph.In();
+//     auto _dry = graph.Add(lowpass, { _in });
+//     auto _wet = graph.Add(chorus >> delay, { _in, { _dry, 0.5 } });
+//     graph.Output(graph.Sum({ _dry, _wet }));
+//
+// Nodes are added before preparing, the modules in the stages are owned and prepared
+// by the voice or engine, like the modules of a chain.
+class Graph final : public Module
+{
+public:
+    struct Node
+    {
+        int index = -1;
+    };
+
+    struct Input
+    {
+        Input(Node n, Sample g = 1) : node(n), gain(g) {}
+
+        Node node;
+        Sample gain = 1;
+    };
+
+    Graph() { m_Nodes.emplace_back(); }
+
+    // The block the graph processes
+    Node In() const { return { 0 }; }
+
+    // Node that runs the sum of its inputs through a stage, nodes without inputs get silence
+    Node Add(ChainFun stage, std::initializer_list<Input> inputs);
+
+    template<std::derived_from<Module> Ty>
+    Node Add(Ty& module, std::initializer_list<Input> inputs) { return Add(ChainFun{ ModuleStage<Ty>{ module } }, inputs); }
+
+    // Node that only sums its inputs
+    Node Sum(std::initializer_list<Input> inputs) { return Add(ChainFun{}, inputs); }
+
+    // Add an input to a node that was already added, the graph has to stay acyclic
+    void Send(Node from, Node to, Sample gain = 1);
+
+    // Node written to the block, the last added node by default
+    void Output(Node node) { m_Output = node.index; }
+
+    // Sort the nodes and assign their buffers
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
+    Sample Apply(Sample s, Channel c) override;
+    void ProcessBlock(std::span<Sample> block, int channels) override;
+
+    // Scratch buffers of the schedule after preparing, besides the block itself
+    int Buffers() const { return m_Buffers; }
+
+    // Nodes in the schedule after preparing, nodes that don't reach the output are left out
+    int Scheduled() const { return static_cast<int>(m_Schedule.size()); }
+
+private:
+    struct Vertex
+    {
+        ChainFun stage;
+        std::vector<Input> inputs;
+    };
+
+    // Buffer 0 is the block, the others are scratch buffers
+    struct Read
+    {
+        int buffer;
+        Sample gain;
+    };
+
+    struct Step
+    {
+        int node = 0;
+        int buffer = 0;         // Output
+        bool inPlace = false;   // Output is the buffer of the first read, with a gain of 1
+        std::size_t begin = 0;  // Reads
+        std::size_t end = 0;
+    };
+
+    std::vector<Vertex> m_Nodes;
+    int m_Output = -1;
+
+    std::vector<Step> m_Schedule;
+    std::vector<Read> m_Reads;
+    int m_Result = 0;     // Buffer of the output
+    int m_Buffers = 0;
+    std::size_t m_Size = 0; // Samples per buffer
+    std::vector<Sample> m_Scratch;
+    std::vector<Sample> m_Values; // A sample per buffer, for Apply
+
+    std::span<Sample> m_Buffer(std::span<Sample> block, int buffer);
+};
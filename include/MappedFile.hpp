@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Read-only memory mapped file, so large files are paged in as they're read
+// instead of loaded up front.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False when the file can't be opened, an empty file maps to no data
+    bool Open(const std::string& path);
+    void Close();
+
+    std::span<const std::uint8_t> Data() const { return { m_Data, m_Size }; }
+
+private:
+    const std::uint8_t* m_Data = nullptr;
+    std::size_t m_Size = 0;
+#ifdef _WIN32
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+#endif
+};
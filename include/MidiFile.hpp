@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Engine.hpp"
+#include "MappedFile.hpp"
+
+// Standard midi file, format 0 or 1, streamed from a memory mapped file. The tracks
+// are merged while reading and ticks are converted to frames with the tempo changes
+// read so far, so only a read position per track is kept and files of any length
+// start playing right away.
+class MidiFile
+{
+public:
+    // False when the file can't be read or isn't a midi file
+    bool Open(const std::string& path, double sampleRate);
+
+    // Next note in time order, with its frame from the start of the file. False after
+    // the last note. Note on with velocity 0 is a release.
+    bool Next(Engine::Event& event);
+
+    // Read from the start again
+    void Rewind();
+
+    int Format() const { return m_Format; }
+    int Tracks() const { return static_cast<int>(m_Chunks.size()); }
+
+private:
+    struct Chunk
+    {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct Track
+    {
+        std::size_t position;
+        std::size_t end;
+        std::uint64_t tick;        // Of the next event
+        std::uint8_t status = 0;   // Running status
+        int index;                 // Tracks earlier in the file go first on the same tick
+    };
+
+    MappedFile m_File;
+    std::vector<Chunk> m_Chunks;
+    std::vector<Track> m_Tracks; // Heap on the tick of the next event
+    int m_Format = 0;
+    double m_SampleRate = 44100;
+
+    // Ticks per quarter note, or per second for smpte time
+    double m_Division = 480;
+    bool m_Smpte = false;
+
+    // Frames are counted from the last tempo change
+    std::uint64_t m_TempoTick = 0;
+    double m_TempoFrame = 0;
+    double m_FramesPerTick = 0;
+
+    void m_Tempo(std::uint64_t tick, double secondsPerQuarter);
+    bool m_Delta(Track& track);
+    bool m_Read(Track& track, Engine::Event& event);
+};
@@ -1,11 +1,23 @@
 #pragma once
-#include "pch.hpp"
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <tuple>
+#include <vector>
+
 #include "Utils.hpp"
+#include "DelayLine.hpp"
 #include "Filter.hpp"
+#include "Monitor.hpp"
+#include "Trace.hpp"
 
 enum Polarity { Positive = 1, Negative = -1 };
 
-using Wavetable = Function<Sample(double, double)>;
+using Wavetable = std::function<Sample(double, double)>;
 namespace Wavetables
 {
     Sample sine(double phase, double wtpos);
@@ -13,6 +25,143 @@ namespace Wavetables
     Sample square(double phase, double wtpos);
 }
 
+// Band-limited version of a wavetable, one table per octave where each table
+// only contains the harmonics that fit below nyquist for that octave.
+class MipmapWavetable
+{
+public:
+    constexpr static int SIZE = 2048;   // Samples per table
+    constexpr static int TABLES = 11;   // Table n contains SIZE / 2 >> n harmonics
+
+    MipmapWavetable(const Wavetable& wavetable, double wtpos);
+
+    // Shared tables for a wavetable, tables of plain functions are only calculated once.
+    static std::shared_ptr<const MipmapWavetable> Get(const Wavetable& wavetable, double wtpos);
+
+    // Select the tables for a phase increment per sample, returns the first table 
+    // and sets the blend towards the next table.
+    static int Select(double delta, float& blend);
+
+    // Interpolated lookup, blending between the given table and the next.
+    Sample Lookup(double phase, int table, float blend) const
+    {
+        double _pos = phase * SIZE;
+        int _index = static_cast<int>(_pos);
+        float _frac = _pos - _index;
+        const float* _a = &m_Tables[table * (SIZE + 1) + _index];
+        float _s1 = _a[0] + (_a[1] - _a[0]) * _frac;
+        if (blend == 0)
+            return _s1;
+
+        const float* _b = _a + (SIZE + 1);
+        float _s2 = _b[0] + (_b[1] - _b[0]) * _frac;
+        return _s1 + (_s2 - _s1) * blend;
+    }
+
+    // All tables, one after the other
+    const float* Data() const { return m_Tables.data(); }
+
+private:
+    std::vector<float> m_Tables; // TABLES tables of SIZE + 1 samples, last one wraps
+};
+
+// Shape of an envelope segment, x^curve for x from 0 to 1, so envelopes look up
+// their curves instead of calling pow every sample.
+class CurveTable
+{
+public:
+    constexpr static int SIZE = 1024;
+
+    constexpr static int MAX_SHARED = 256; // Tables Find can return
+
+    CurveTable(double curve);
+
+    // Shared table for a curve, only calculated once per curve. Locks and allocates,
+    // so call it off the audio thread. Tables live until the program ends.
+    static const CurveTable& Get(double curve);
+
+    // Table of a curve that Get already calculated, nullptr otherwise. Doesn't lock
+    // or allocate, for curves that change on the audio thread.
+    static const CurveTable* Find(double curve);
+
+    // Interpolated lookup, x between 0 and 1
+    float Lookup(double x) const
+    {
+        double _pos = x * SIZE;
+        int _index = std::min(static_cast<int>(_pos), SIZE - 1);
+        float _frac = _pos - _index;
+        return m_Table[_index] + (m_Table[_index + 1] - m_Table[_index]) * _frac;
+    }
+
+    double Curve() const { return m_Curve; }
+
+private:
+    double m_Curve;
+    std::vector<float> m_Table; // SIZE + 1 samples, last one is 1
+};
+
+// Last values of the inputs of derived values, like filter coefficients, so they're 
+// only recalculated when one of the inputs changed.
+template<class ...Ty>
+class Snapshot
+{
+public:
+    // True on the first call, and when any value differs from the last call
+    bool Changed(const Ty&... values)
+    {
+        if (m_Valid && m_Values == std::tie(values...))
+            return false;
+
+        m_Values = { values... };
+        m_Valid = true;
+        return true;
+    }
+
+    void Invalidate() { m_Valid = false; }
+
+private:
+    std::tuple<Ty...> m_Values;
+    bool m_Valid = false;
+};
+
+// Linear ramp from the value of the last block to a new value over the frames of a
+// block, so values that are set once per block, like settings changed by Mod from a
+// Param, don't step at block boundaries.
+class Ramp
+{
+public:
+    Ramp(Sample value = 0) : m_Value(value), m_Target(value) {}
+
+    // Ramp to the target over the next frames
+    void Target(Sample target, std::size_t frames)
+    {
+        m_Target = target;
+        m_Frames = frames;
+        m_Step = frames > 0 ? (target - m_Value) / frames : 0;
+        if (frames == 0)
+            m_Value = target;
+    }
+
+    // Value of the current frame, steps to the next one and lands on the target
+    Sample Next()
+    {
+        Sample _value = m_Value;
+        if (m_Frames > 0 && --m_Frames == 0)
+            m_Value = m_Target;
+        else
+            m_Value += m_Step;
+        return _value;
+    }
+
+    Sample Value() const { return m_Value; }
+
+private:
+    Sample m_Value;
+    Sample m_Target;
+    Sample m_Step = 0;
+    std::size_t m_Frames = 0;
+};
+
 struct Range
 {
     double middle = 0;
@@ -22,10 +171,46 @@ struct Range
 class Module
 {
 public:
-    static inline double SAMPLE_RATE = 44100.;
+    static inline int CONTROL_RATE = 32; // Frames between modulation updates when processing blocks
+
+    virtual ~Module() = default;
+
+    // Allocate everything processing needs for a format, called off the audio thread 
+    // before processing and whenever the format changes. Blocks never exceed the maximum.
+    // Overrides call this first, it keeps the sample rate for processing.
+    virtual void Prepare(double sampleRate, int, int) { m_SampleRate = sampleRate; }
+
+    // Sample rate the module was prepared for
+    double SampleRate() const { return m_SampleRate; }
+
+    // Processing is done in frames: Generate advances everything that is shared by
+    // the channels once, then Apply processes the sample of every channel.
+    virtual void Generate() {};
+    virtual Sample Apply(Sample sample = 0, Channel = 0) { return sample; };
+
+    // Advance a generator that is only read by modulation by a number of frames at
+    // once. Modules that don't override it are generated for every frame.
+    virtual void Advance(int frames)
+    {
+        for (int i = 0; i < frames; i++)
+            Generate();
+    }
 
-    virtual Sample Apply(Sample sample = 0, Channel channel = 0) { return sample; };
-    virtual void Generate(Channel channel = 0) {};
+    // Process a block of interleaved frames, equivalent to calling Generate and then 
+    // Apply for each channel of every frame. Modules that haven't been ported to the 
+    // block api fall back to that.
+    virtual void ProcessBlock(std::span<Sample> block, int channels)
+    {
+        for (std::size_t i = 0; i < block.size(); i += channels)
+        {
+            Generate();
+            for (int c = 0; c < channels; c++)
+                block[i + c] = Apply(block[i + c], c);
+        }
+    }
+
+protected:
+    double m_SampleRate = 44100;
 };
 
 class Generator : public Module
@@ -53,14 +238,84 @@ public:
     Sample sample = 0;
 };
 
+// Chain stage that forwards to a module
+template<std::derived_from<Module> T>
+struct ModuleStage
+{
+    T& module;
+
+    // Generated before the first channel of every frame, like the default ProcessBlock
+    Sample operator()(Sample s, Channel c)
+    {
+        if (c == 0)
+            module.Generate();
+        return module.Apply(s, c);
+    }
+
+    void operator()(std::span<Sample> block, int channels)
+    {
+        Monitor::Scope<T> _scope;
+        Trace::Scope _trace{ typeid(T) };
+        module.ProcessBlock(block, channels);
+    }
+};
+
+// Chain stage that feeds the output of one stage into the next, stages 
+// that can't process blocks are called for each sample.
+template<std::invocable<Sample, Channel> T1, std::invocable<Sample, Channel> T2>
+struct ChainStage
+{
+    T1 first;
+    T2 second;
+
+    Sample operator()(Sample s, Channel c) { return second(first(s, c), c); }
+    void operator()(std::span<Sample> block, int channels) { Process(first, block, channels); Process(second, block, channels); }
+
+private:
+    template<class Ty>
+    static void Process(Ty& stage, std::span<Sample> block, int channels)
+    {
+        if constexpr (std::invocable<Ty&, std::span<Sample>, int>)
+            stage(block, channels);
+        else
+            for (std::size_t i = 0; i < block.size(); i++)
+                block[i] = stage(block[i], i % channels);
+    }
+};
+
 template<std::invocable<Sample, Channel> T1, std::derived_from<Module> T2>
-auto operator >>(T1&& t1, T2& t2) { return [t1 = std::move(t1), &t2](Sample s, Channel c) mutable { return t2.Apply(t1(s, c), c); }; }
+auto operator >>(T1&& t1, T2& t2) { return ChainStage<std::decay_t<T1>, ModuleStage<T2>>{ std::forward<T1>(t1), { t2 } }; }
 
 template<std::invocable<Sample, Channel> T1, std::invocable<Sample, Channel> T2>
-auto operator >>(T1&& t1, T2&& t2) { return [t1 = std::move(t1), t2 = std::move(t2)](Sample s, Channel c) mutable { return t2(t1(s, c), c); }; }
+auto operator >>(T1&& t1, T2&& t2) { return ChainStage<std::decay_t<T1>, std::decay_t<T2>>{ std::forward<T1>(t1), std::forward<T2>(t2) }; }
 
 template<std::derived_from<Module> T1, std::derived_from<Module> T2>
-auto operator >>(T1& t1, T2& t2) { return [&](Sample s, Channel c) { return t2.Apply(t1.Apply(s, c), c); }; }
+auto operator >>(T1& t1, T2& t2) { return ChainStage<ModuleStage<T1>, ModuleStage<T2>>{ { t1 }, { t2 } }; }
+
+// Type-erased chain, can be called for a single sample or for a block of interleaved frames.
+class ChainFun
+{
+public:
+    ChainFun() = default;
+
+    template<std::invocable<Sample, Channel> T>
+        requires (!std::same_as<std::decay_t<T>, ChainFun>)
+    ChainFun(T&& chain)
+    {
+        // Both signatures share the same chain so stateful stages stay in sync
+        auto _chain = std::make_shared<std::decay_t<T>>(std::forward<T>(chain));
+        m_Sample = [_chain](Sample s, Channel c) { return (*_chain)(s, c); };
+        m_Block = [_chain](std::span<Sample> block, int channels) { (*_chain)(block, channels); };
+    }
+
+    Sample operator()(Sample s, Channel c) const { return m_Sample(s, c); }
+    void operator()(std::span<Sample> block, int channels) const { m_Block(block, channels); }
+    explicit operator bool() const { return (bool)m_Sample; }
+
+private:
+    std::function<Sample(Sample, Channel)> m_Sample;
+    std::function<void(std::span<Sample>, int)> m_Block;
+};
 
 class Envelope : public Generator
 {
@@ -70,7 +325,7 @@ public:
     virtual bool Done() { return true; }
 };
 
-class ADSR : public Envelope
+class ADSR final : public Envelope
 {
 public:
     struct Settings
@@ -87,10 +342,14 @@ public:
         bool legato = false;
     } settings;
 
-    ADSR(const Settings& s = {}) : settings(s) {};
+    ADSR() = default;
+    ADSR(const Settings& s) : settings(s) {}
 
     Sample Apply(Sample s, Channel) override { return sample * s; }
-    void Generate(Channel) override;
+    void Generate() override { Advance(1); }
+    void Advance(int frames) override;
+    void ProcessBlock(std::span<Sample> block, int channels) override;
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
     void Trigger() override;
     void Gate(bool g) override;
     bool Done() override { return m_Phase == -1; }
@@ -99,9 +358,23 @@ private:
     Sample m_Down = 0;
     double m_Phase = -1;
     bool m_Gate = false;
+
+    // Curve tables and 1 / length of the attack, decay and release. Curves without a
+    // table, set on the audio thread after preparing, are calculated with pow.
+    double m_Curve[3]{ -1, -1, -1 };
+    const CurveTable* m_Curves[3]{};
+    double m_Inverse[3]{};
+
+    float m_Shape(int segment, double x) const
+    {
+        return m_Curves[segment] ? m_Curves[segment]->Lookup(x) : std::pow(x, m_Curve[segment]);
+    }
+
+    void m_Segments();
+    void m_Advance(int frames);
 };
 
-class LPF : public Module
+class LPF final : public Module
 {
 public:
     struct Settings
@@ -111,17 +384,28 @@ public:
         double mix = 1;
     } settings;
     
-    LPF(const Settings& s = {}) : settings(s) {}
+    LPF() = default;
+    LPF(const Settings& s) : settings(s) {}
 
-    void Generate(Channel) override;
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
+    void Generate() override;
     Sample Apply(Sample s, Channel) override;
+    void ProcessBlock(std::span<Sample> block, int channels) override;
 
 private:
+    using Filter = Biquad<double>;
+
     BiquadParameters m_Params;
-    StereoEqualizer<2, BiquadFilter<>> m_Filter{ m_Params };
+    Filter m_Filter;
+    Filter::Coefficients m_Coefficients; // At the end of the last block
+    bool m_Interpolate = false;
+    Snapshot<double, double, double, double> m_Settings; // Sample rate, frequency, resonance, mix
+
+    // Coefficients of the filter mixed with the dry signal, the mix only changes the zeros
+    Filter::Coefficients m_Mixed() const;
 };
 
-class Oscillator : public Generator
+class Oscillator final : public Generator
 {
 public:
     struct Settings
@@ -129,22 +413,37 @@ public:
         float frequency = 440;
         float wtpos = 0;
         int oversample = 8;
-        Function<Sample(double, double)> wavetable = Wavetables::saw;
+        bool bandlimited = false; // Use mip-mapped tables instead of oversampling
+        Wavetable wavetable = Wavetables::saw;
     } settings;
 
-    Oscillator(const Settings& s = {}) : settings(s) {}
+    Oscillator() { UpdateTables(); }
+    Oscillator(const Settings& s) : settings(s) { UpdateTables(); }
 
-    void Generate(Channel) override;
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
+    void Generate() override;
+    void Advance(int frames) override;
     Sample Apply(Sample s = 0, Channel = 0) override;
+    void ProcessBlock(std::span<Sample> block, int channels) override;
     Sample Offset(double phaseoffset);
 
+    // Recalculate the band-limited tables, call after changing the wavetable or wtpos.
+    // Locks and allocates, without tables the oscillator oversamples instead.
+    void UpdateTables();
+
 private:
-    BiquadParameters m_Params;
-    BiquadFilter<> m_Filter[1];
+    BiquadParameters m_Params; // Anti-aliasing filter at the oversampled rate
+    Biquad<float, 1, 1> m_Filter;
+    Snapshot<double, int> m_Rate; // Sample rate, oversample
     float m_Phase = 0;
+
+    std::shared_ptr<const MipmapWavetable> m_Tables;
+    float m_Frequency = 0;
+    int m_Table = 0;
+    float m_Blend = 0;
 };
 
-class Chorus : public Module
+class Chorus final : public Module
 {
 public:
     struct Settings
@@ -160,20 +459,23 @@ public:
         Polarity polarity = Negative;
     } settings;
 
-    Chorus(const Settings& s = {}) : settings(s) {}
+    Chorus() = default;
+    Chorus(const Settings& s) : settings(s), m_Mix(s.mix) {}
 
-    void Channels(int c);
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
+    void Generate() override;
     Sample Apply(Sample sin, Channel c) override;
+    void ProcessBlock(std::span<Sample> block, int channels) override;
 
 private:
     constexpr static int BUFFER_SIZE = 2048;
-    std::vector<std::vector<float>> m_Buffers;
-    int m_Position = 0;
-    int m_Delay1t = 5;
-    int m_Delay2t = 5;
+    DelayLine<float> m_Line;
+    Ramp m_Mix{ 0.5 };
+
+    Sample m_Apply(Sample sin, Channel c, Sample mix);
 };
 
-class Delay : public Module
+class Delay final : public Module
 {
 public:
     struct Settings
@@ -187,30 +489,41 @@ public:
         struct {
             double amount = 0;
             double rate = 0.4;
-        } mod;
+        } mod{};
 
     } settings;
 
-    Delay(const Settings& s = {}) : settings(s) {}
+    Delay() = default;
+    Delay(const Settings& s) : settings(s), m_Mix(s.mix) {}
 
-    void Channels(int c);
-    void Generate(Channel c) override;
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
+    void Generate() override;
     Sample Apply(Sample sin, Channel c) override;
+    void ProcessBlock(std::span<Sample> block, int channels) override;
 
 private:
-    std::vector<std::vector<float>> m_Buffers;
-    int BUFFER_SIZE = SAMPLE_RATE * 10;
-    int m_Position = 0;
+    DelayLine<float> m_Line; // 10 seconds
+    std::vector<float> m_Block; // Delayed frames of a block
 
     Oscillator m_Oscillator{ { .wavetable = Wavetables::sine } };
 
     SimpleFilterParameters m_Parameters;
-    std::vector<ChannelEqualizer<2, BiquadFilter<>>> m_Equalizers;
+    Biquad<double, 2> m_Filter; // Highpass and lowpass of the feedback
+    Snapshot<double, double, double> m_Filters; // Sample rate, frequency, width
+
+    Snapshot<double> m_Gains;
+    float m_Gain = 1;
+    Ramp m_Mix{ 0.5 };
+
+    Sample m_Apply(Sample sin, Channel c, Sample mix);
+
+    // Recalculate the filters and gain when their settings changed
+    void m_Update();
 
     bool m_Dragging = false;
 };
 
-class Gain : public Module
+class Gain final : public Module
 {
 public:
     struct Settings
@@ -218,6 +531,31 @@ public:
         double gain = 0;
     } settings;
 
-    Gain(const Settings& s = {}) : settings(s) {}
-    Sample Apply(Sample s, Channel) override { return db2lin(settings.gain) * s; }
+    Gain() = default;
+    Gain(const Settings& s) : settings(s), m_Gain(db2lin(s.gain)) {}
+    Sample Apply(Sample s, Channel) override { return m_Linear() * s; }
+    void ProcessBlock(std::span<Sample> block, int channels) override 
+    {
+        // Ramp from the gain of the previous block, so changes don't click
+        m_Gain.Target(m_Linear(), block.size() / channels);
+        for (std::size_t i = 0; i < block.size(); i += channels)
+        {
+            Sample _gain = m_Gain.Next();
+            for (int c = 0; c < channels; c++)
+                block[i + c] *= _gain;
+        }
+    }
+
+private:
+    Ramp m_Gain{ 1 };
+    Sample m_Target = 1;
+    Snapshot<double> m_Settings;
+
+    // Gain setting as a factor, only calculated when the setting changed
+    Sample m_Linear()
+    {
+        if (m_Settings.Changed(settings.gain))
+            m_Target = db2lin(settings.gain);
+        return m_Target;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+
+// Real-time performance counters of the audio thread. Every block is timed against
+// its duration, and the counters are published once per block in a triple buffer, so
+// a gui can read the latest stats without locking. Without SYNTHMAKR_MONITOR all
+// measuring compiles to nothing and the stats stay empty.
+class Monitor
+{
+public:
+#ifdef SYNTHMAKR_MONITOR
+    constexpr static bool ENABLED = true;
+#else
+    constexpr static bool ENABLED = false;
+#endif
+
+    constexpr static int BUCKETS = 12; // Block load in steps of 10%, the last is 110% and up
+    constexpr static int MAX_MODULES = 32;
+
+    struct Module
+    {
+        const char* type = nullptr; // Mangled type name, see Name
+        std::uint64_t calls = 0;    // Blocks processed
+        double seconds = 0;
+    };
+
+    struct Stats
+    {
+        std::uint64_t blocks = 0;
+        double load = 0;    // Last block, percent of the real-time duration of the block
+        double average = 0; // Load over about the last second
+        double peak = 0;    // Highest load so far
+        double longest = 0; // Longest block, seconds
+        std::uint64_t overruns = 0; // Blocks that took longer than their duration
+        std::uint64_t xruns = 0;    // Blocks that started more than half a block late
+        int voices = 0;             // Voices playing in the last block
+        std::array<std::uint64_t, BUCKETS> histogram{};
+
+        // Module time summed over all voices and the master chain, by module type
+        int modules = 0;
+        std::array<Module, MAX_MODULES> module{};
+    };
+
+    // Audio thread, around every block
+    void Begin(std::int64_t frames, double sampleRate) { if constexpr (ENABLED) m_Begin(frames, sampleRate); }
+    void End(int voices) { if constexpr (ENABLED) m_End(voices); }
+
+    // Audio thread, the next block doesn't continue the previous one, like after
+    // the device was restarted, so the gap isn't counted as an xrun.
+    void Restart() { m_Start = 0; }
+
+    // Latest published stats, for one reader thread at a time
+    Stats Read();
+
+    // Time the blocks of every module, off by default since it reads the clock around
+    // every module in every voice. Module time is shared by all engines.
+    static void TimeModules(bool time) { m_TimeModules.store(time, std::memory_order_relaxed); }
+
+    // Measures a module block when module timing is on
+    template<class Ty>
+    class Scope
+    {
+    public:
+        Scope()
+        {
+            if constexpr (ENABLED)
+                if (m_TimeModules.load(std::memory_order_relaxed))
+                    m_Start = Ticks();
+        }
+
+        ~Scope()
+        {
+            if constexpr (ENABLED)
+                if (m_Start)
+                    m_Add(Slot<Ty>(), Ticks() - m_Start);
+        }
+
+    private:
+        std::uint64_t m_Start = 0;
+    };
+
+    // Readable name of a module type
+    static std::string Name(const char* type);
+    static std::string Json(const Stats& stats);
+
+private:
+    struct Counter
+    {
+        std::atomic<const char*> type = nullptr;
+        std::atomic<std::uint64_t> calls = 0;
+        std::atomic<std::uint64_t> ticks = 0;
+    };
+
+    constexpr static int FRESH = 4; // Set in m_Middle when it wasn't read yet
+
+    std::array<Stats, 3> m_Buffers{};
+    std::atomic<int> m_Middle = 1;
+    int m_Back = 0;  // Written by the audio thread
+    int m_Front = 2; // Read by the reader
+
+    // Audio thread
+    Stats m_Stats{};
+    std::int64_t m_Start = 0; // Nanoseconds, 0 when not continuing a block
+    std::uint64_t m_StartTicks = 0;
+    double m_Period = 0;      // Seconds of the last block
+    std::uint64_t m_Nanoseconds = 0; // Summed block time, to convert ticks to seconds
+    std::uint64_t m_Ticks = 0;
+
+    static inline std::atomic<bool> m_TimeModules = false;
+    static inline std::atomic<int> m_Modules = 0;
+    static std::array<Counter, MAX_MODULES> m_Counters;
+
+    // Cycle counter where available, otherwise nanoseconds
+    static std::uint64_t Ticks();
+
+    template<class Ty>
+    static int Slot()
+    {
+        static const int _slot = m_Register(typeid(Ty).name());
+        return _slot;
+    }
+
+    static int m_Register(const char* type);
+    static void m_Add(int slot, std::uint64_t ticks);
+    void m_Begin(std::int64_t frames, double sampleRate);
+    void m_End(int voices);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "pch.hpp"
+#include <format>
+#include "Engine.hpp"
+
+// Overlay with the performance counters of an engine, read once per gui frame
+struct MonitorPanel : public Component
+{
+    struct Settings
+    {
+        Engine* engine = nullptr;
+        int modules = 4; // Modules with the most time that are listed
+        int fontSize = 12;
+        Color background{ 0, 0, 0, 200 };
+        Color text{ 255, 255, 255, 255 };
+        Color bars{ 109, 215, 255, 255 };
+        Color overload{ 255, 90, 90, 255 }; // Histogram buckets over 100%
+    } settings;
+
+    MonitorPanel(const Settings& s = {}) : settings(s) {}
+
+    void Update() override
+    {
+        if (!settings.engine)
+            return;
+
+        m_Stats = settings.engine->Stats();
+        m_Lines.clear();
+        m_Lines.push_back(std::format("Load {:.1f}%  avg {:.1f}%  peak {:.1f}%", m_Stats.load, m_Stats.average, m_Stats.peak));
+        m_Lines.push_back(std::format("Overruns {}  xruns {}", m_Stats.overruns, m_Stats.xruns));
+        m_Lines.push_back(std::format("Voices {}", m_Stats.voices));
+
+        // Share of the module time, most expensive first
+        std::vector<Monitor::Module> _modules{ m_Stats.module.begin(), m_Stats.module.begin() + m_Stats.modules };
+        std::ranges::sort(_modules, std::greater{}, &Monitor::Module::seconds);
+        double _total = 0;
+        for (auto& i : _modules)
+            _total += i.seconds;
+
+        for (auto& i : _modules | std::views::take(settings.modules))
+            if (_total > 0)
+                m_Lines.push_back(std::format("{} {:.0f}%", Monitor::Name(i.type), i.seconds / _total * 100));
+    }
+
+    void Render(CommandCollection& d) const override
+    {
+        d.Fill(settings.background);
+        d.Quad(dimensions);
+
+        float _line = settings.fontSize + 4;
+        d.Fill(settings.text);
+        d.FontSize(settings.fontSize);
+        d.TextAlign(Align::CenterY | Align::Left);
+        d.Font(GraphicsBase::DefaultFont);
+        for (std::size_t i = 0; i < m_Lines.size(); i++)
+            d.Text(m_Lines[i], { x + 6, y + 4 + _line * (i + 0.5f) });
+
+        // Block load histogram along the bottom, scaled to the largest bucket
+        std::uint64_t _max = std::ranges::max(m_Stats.histogram);
+        if (_max == 0)
+            return;
+
+        float _top = y + 8 + _line * m_Lines.size();
+        float _height = y + height - 6 - _top;
+        float _width = (width - 12) / Monitor::BUCKETS;
+        for (int i = 0; i < Monitor::BUCKETS; i++)
+        {
+            float _bar = _height * m_Stats.histogram[i] / _max;
+            d.Fill(i >= 10 ? settings.overload : settings.bars);
+            d.Quad({ x + 6 + i * _width, _top + _height - _bar, _width - 1, _bar });
+        }
+    }
+
+private:
+    Monitor::Stats m_Stats;
+    std::vector<std::string> m_Lines;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+
+// Parameter value shared between the gui and the audio thread. Any thread sets
+// the target atomically, the audio thread reads it once per block and ramps
+// towards it, so modulation code only reads a plain value.
+class Param
+{
+public:
+    enum Curve { Linear, Exponential };
+
+    struct Settings
+    {
+        double value = 0;
+        double time = 0.02; // Seconds to reach a new target
+        Curve curve = Linear;
+    } settings;
+
+    Param() : Param(Settings{}) {}
+    Param(const Settings& s) : settings(s), m_Target(s.value), m_Value(s.value), m_Goal(s.value) {}
+
+    // Thread-safe
+    void Set(double value) { m_Target.store(value, std::memory_order_relaxed); }
+    double Target() const { return m_Target.load(std::memory_order_relaxed); }
+
+    // Audio thread, step the smoothed value by a block of frames
+    void Advance(int frames, double sampleRate)
+    {
+        double _target = Target();
+        double _length = settings.time * sampleRate;
+        if (_target != m_Goal)
+        {
+            m_Goal = _target;
+            m_Step = _length > 0 ? (m_Goal - m_Value) / _length : 0;
+            m_Remaining = _length;
+        }
+
+        if (m_Remaining <= frames || _length <= 0)
+        {
+            m_Value = m_Goal, m_Remaining = 0;
+            return;
+        }
+
+        m_Remaining -= frames;
+        if (settings.curve == Linear)
+            m_Value += m_Step * frames;
+        else // One pole that gets within 1% of the target in time
+            m_Value = m_Goal + (m_Value - m_Goal) * std::exp(-4.6 * frames / _length);
+    }
+
+    // Smoothed value at the end of the current block
+    double Value() const { return m_Value; }
+    operator double() const { return m_Value; }
+
+private:
+    std::atomic<double> m_Target;
+    double m_Value;
+    double m_Goal;
+    double m_Step = 0;
+    double m_Remaining = 0; // frames
+};
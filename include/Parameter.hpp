@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.hpp"
 #include "Unit.hpp"
+#include "Param.hpp"
 
 struct Parameter : public Component
 {
@@ -11,6 +12,7 @@ struct Parameter : public Component
         Vec2<double> range{ -24, 24 };  // Range of the parameter
 
         std::string name = "Param"; // Name of the parameter
+        Param* param = nullptr; // Audio thread value, updated when the value changes
 
         Function<double(double)> scaling = [](double in) { return in; }; // Scaling of the mouse dragging
         Function<double(double)> inverse = [](double in) { return in; }; // Inverse of the scaling of the mouse dragging
@@ -62,6 +64,7 @@ struct Parameter : public Component
         size = { 50, 65 };
 
         settings.Link(this);
+        Publish();
 
         *this += [this](const MousePress& e)
         {
@@ -76,7 +79,7 @@ struct Parameter : public Component
             auto _now = std::chrono::steady_clock::now();
             auto _duration = std::chrono::duration_cast<std::chrono::milliseconds>(_now - m_ChangeTime).count();
             if (_duration < 500)
-                settings.value = settings.reset;
+                settings.value = settings.reset, Publish();
 
             m_ChangeTime = _now;
         };
@@ -96,6 +99,8 @@ struct Parameter : public Component
 
             if (settings.scaling)
                 settings.value = settings.scaling(constrain(m_PressVal, 0.f, 1.f)) * (settings.range.end - settings.range.start) + settings.range.start;
+
+            Publish();
         };
 
         m_ValueBox += [this](const Unfocus&)
@@ -107,6 +112,7 @@ struct Parameter : public Component
                 double i = std::stod(out);
                 settings.value = i;
                 settings.value = constrain(settings.value, settings.range.start, settings.range.end);
+                Publish();
             }
             catch (std::invalid_argument const& e) {
             }
@@ -189,6 +195,9 @@ struct Parameter : public Component
 
     operator double& () { return settings.value; }
 
+    // Send the value to the audio thread
+    void Publish() { if (settings.param) settings.param->Set(settings.value); }
+
 private:
     std::chrono::steady_clock::time_point m_ChangeTime;
     TextBox& m_ValueBox = emplace_back<TextBox>();
@@ -0,0 +1,151 @@
+#pragma once
+#include <string>
+
+#include "Engine.hpp"
+#include "Graph.hpp"
+#include "SimdVoices.hpp"
+
+// Voice of the default patch, shared by the gui synth and the headless renderer. The 
+// parent provides the parameters, either as gui parameters or as plain values. The 
+// oscillator oversamples, or uses the mip-mapped tables when Bandlimited.
+template<class Parent, bool Bandlimited = false>
+struct MyVoice : Engine::StaticVoice<Parent, MyVoice<Parent, Bandlimited>>
+{
+    using Engine::StaticVoice<Parent, MyVoice<Parent, Bandlimited>>::StaticVoice;
+
+    Oscillator& osc = this->template Add<Oscillator>({ .bandlimited = Bandlimited });
+    Oscillator& lfo = this->Control(this->template Add<Oscillator>({ .frequency = 0.5, .wavetable = Wavetables::sine }));
+    ADSR& gain      = this->template Add<ADSR>({ .release = 2 });
+    ADSR& filter    = this->Control(this->template Add<ADSR>({ .attack = 0.5, .decay = 5.5, .sustain = 0, .release = 2, .attackCurve = 0.9, .decayCurve = 0.2, .legato = true }));
+    Chorus& chorus  = this->template Add<Chorus>({ .oscillator{ { .frequency = 3, .wavetable = Wavetables::sine } } });
+    LPF& lowpass    = this->template Add<LPF>({ .resonance = 1 });
+
+    auto Pipeline() { return osc >> gain >> lowpass >> chorus; }
+
+    void Mod() override
+    {
+        lowpass.settings.resonance = this->synth.filterReso;
+        chorus.settings.mix = this->synth.chorusMix / 100.;
+        lowpass.settings.mix = this->synth.filterMix / 100.;
+        lfo.settings.frequency = 3 - filter * 3;
+        lowpass.settings.frequency = filter * filter * 16000 + 200;
+        lowpass.settings.frequency += lfo * 400 + 300;
+    }
+
+    void NotePress(int n, int) override
+    {
+        osc.settings.frequency = noteToFreq(n);
+        gain.Gate(true), filter.Gate(true);
+    }
+
+    void NoteRelease(int) override { gain.Gate(false); filter.Gate(false); }
+    bool Done() override { return gain.Done() && filter.Done(); }
+    Sample Level() override { return gain.sample; }
+};
+
+// Headless version of the default patch, optionally with band-limited oscillators
+struct MyPatch : public Engine
+{
+    Param& chorusMix = AddParam({ .value = 50 });
+    Param& delayMix = AddParam({ .value = 50 });
+    Param& filterMix = AddParam({ .value = 100 });
+    Param& filterReso = AddParam({ .value = 0.6 });
+    Param& gainP = AddParam({ .value = 0 });
+
+    Delay& delay = Add<Delay>();
+    Gain& gain = Add<Gain>();
+
+    MyPatch(bool bandlimited = false)
+    {
+        if (bandlimited)
+            AddVoices<MyVoice<MyPatch, true>>(8);
+        else
+            AddVoices<MyVoice<MyPatch>>(8);
+    }
+
+    void Mod() override
+    {
+        delay.settings.mix = delayMix / 100.;
+        gain.settings.gain = gainP;
+    }
+
+    ChainFun Chain() override { return gain >> delay; }
+};
+
+// Default patch with all voices in simd lanes, the chorus runs once on the mixed voices
+struct MySimdPatch : public Engine
+{
+    Param& chorusMix = AddParam({ .value = 50 });
+    Param& delayMix = AddParam({ .value = 50 });
+    Param& filterMix = AddParam({ .value = 100 });
+    Param& filterReso = AddParam({ .value = 0.6 });
+    Param& gainP = AddParam({ .value = 0 });
+
+    SimdVoices& voices = Add<SimdVoices>({
+        .voices = 8,
+        .gain{ .release = 2 },
+        .filter{ .attack = 0.5, .decay = 5.5, .sustain = 0, .release = 2, .attackCurve = 0.9, .decayCurve = 0.2, .legato = true },
+        .lfo{ .frequency = 3, .envelope = -3 },
+        .lowpass{ .frequency = 500, .envelope = 16000, .lfo = 400 },
+    });
+    Chorus& chorus = Add<Chorus>({ .oscillator{ { .frequency = 3, .wavetable = Wavetables::sine } } });
+    Delay& delay = Add<Delay>();
+    Gain& gain = Add<Gain>();
+
+    void NotePress(int note, int velocity) override { voices.NotePress(note, velocity); }
+    void NoteRelease(int note, int) override { voices.NoteRelease(note); }
+    void Stealing(VoiceAllocator::Policy policy) override { voices.settings.stealing = policy; }
+
+    void Mod() override
+    {
+        voices.settings.lowpass.resonance = filterReso;
+        voices.settings.lowpass.mix = filterMix / 100.;
+        chorus.settings.mix = chorusMix / 100.;
+        delay.settings.mix = delayMix / 100.;
+        gain.settings.gain = gainP;
+    }
+
+    ChainFun Chain() override { return voices >> chorus >> gain >> delay; }
+};
+
+// Default voices routed through a graph: the dry signal and a delay send with darkened 
+// echoes, summed at the output
+struct MyGraphPatch : public Engine
+{
+    Param& chorusMix = AddParam({ .value = 50 });
+    Param& delayMix = AddParam({ .value = 50 });
+    Param& filterMix = AddParam({ .value = 100 });
+    Param& filterReso = AddParam({ .value = 0.6 });
+    Param& gainP = AddParam({ .value = 0 });
+
+    Gain& send = Add<Gain>();
+    Delay& delay = Add<Delay>({ .mix = 1 });
+    LPF& darken = Add<LPF>({ .frequency = 3000, .resonance = 0.7 });
+    Gain& gain = Add<Gain>();
+    Graph& graph = Add<Graph>();
+
+    MyGraphPatch()
+    {
+        AddVoices<MyVoice<MyGraphPatch>>(8);
+
+        auto _in = graph.In();
+        auto _echoes = graph.Add(send >> delay >> darken, { _in });
+        graph.Output(graph.Sum({ _in, _echoes }));
+    }
+
+    void Mod() override
+    {
+        send.settings.gain = delayMix > 0 ? lin2db(delayMix / 100.) : -120;
+        gain.settings.gain = gainP;
+    }
+
+    ChainFun Chain() override { return graph >> gain; }
+};
+
+// Headless patches by name
+static inline std::map<std::string, std::function<std::unique_ptr<Engine>()>> patches{
+    { "default", [] { return std::make_unique<MyPatch>(); } },
+    { "bandlimited", [] { return std::make_unique<MyPatch>(true); } },
+    { "simd", [] { return std::make_unique<MySimdPatch>(); } },
+    { "graph", [] { return std::make_unique<MyGraphPatch>(); } },
+};
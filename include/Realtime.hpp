@@ -0,0 +1,42 @@
+#pragma once
+
+// Real-time safety checks for debug builds. Code inside a Scope runs on a real-time
+// thread, and with SYNTHMAKR_RTSAN every allocation, free and mutex lock in a scope is
+// a violation that is recorded with its stack, or aborts. Allocations are caught in
+// malloc with glibc and in operator new elsewhere, locks only with glibc. Without
+// SYNTHMAKR_RTSAN scopes compile to nothing.
+class Realtime
+{
+public:
+#ifdef SYNTHMAKR_RTSAN
+    constexpr static bool ENABLED = true;
+#else
+    constexpr static bool ENABLED = false;
+#endif
+
+    enum Kind { Allocation, Free, Lock };
+    enum Action { Record, Abort };
+
+    constexpr static int MAX_REPORTS = 32; // Violations with a stack, later ones are only counted
+
+    class Scope
+    {
+    public:
+        Scope() { if constexpr (ENABLED) m_Depth++; }
+        ~Scope() { if constexpr (ENABLED) m_Depth--; }
+    };
+
+    // What happens on a violation, Record by default
+    static void OnViolation(Action action);
+
+    // Violations so far, also the ones that weren't reported
+    static int Violations();
+
+    // Print the recorded violations with their stacks to stderr
+    static void Report();
+
+private:
+    static thread_local int m_Depth;
+
+    friend struct RealtimeHooks;
+};
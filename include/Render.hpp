@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Engine.hpp"
+
+// Note event for offline rendering
+struct NoteEvent
+{
+    double time = 0; // seconds
+    int note = 60;
+    int velocity = 127;
+    bool press = true;
+};
+
+// Renders an engine offline, as fast as possible
+class Renderer
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 44100;
+        int channels = 2;
+        int blockSize = 512;  // frames
+        double tail = 2;      // seconds rendered after the last event
+    } settings;
+
+    Renderer() = default;
+    Renderer(const Settings& s) : settings(s) {}
+
+    // Next event in time order, with its frame from the start of the render. False after the last one.
+    using Source = std::function<bool(Engine::Event&)>;
+
+    // Receives the interleaved output a block at a time
+    using Sink = std::function<void(std::span<const Sample>)>;
+
+    // Prepare the engine, render the events and return the interleaved output. Events are
+    // sent to the engine ahead of each block so every event lands on its exact sample.
+    std::vector<Sample> Render(Engine& engine, std::span<const NoteEvent> events);
+
+    // Source of the events sorted by time, at the sample rate of the settings
+    Source Events(std::vector<NoteEvent> events) const;
+
+    // Render until the source runs out of events, plus the tail. Events are only read
+    // when their block is rendered and the output goes to the sink, so renders of any
+    // length run in constant memory. Returns the rendered frames.
+    std::int64_t Render(Engine& engine, const Source& next, const Sink& out);
+};
+
+// A few bars of chords, for when no events are given
+std::vector<NoteEvent> DefaultEvents();
+
+// Parse note events, one note per line as "<time> <note> <velocity> <duration>" 
+// in seconds, lines starting with '#' are ignored.
+std::vector<NoteEvent> ParseEvents(std::istream& in);
+
+// Write interleaved samples to a 32-bit float wav file
+bool WriteWav(const std::string& path, std::span<const Sample> samples, int channels, double sampleRate);
+
+// Writes a 32-bit float wav file in parts, the sizes in the header are filled in on Close
+class WavWriter
+{
+public:
+    bool Open(const std::string& path, int channels, double sampleRate);
+    bool Write(std::span<const Sample> samples);
+    bool Close();
+
+private:
+    std::ofstream m_File;
+    std::uint64_t m_Samples = 0;
+    std::vector<char> m_Bytes;
+};
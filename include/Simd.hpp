@@ -0,0 +1,8 @@
+#pragma once
+
+// Runtime cpu dispatch for the simd kernels
+namespace Simd
+{
+    // Widest float lane count the cpu supports: 16 (AVX-512), 8 (AVX2) or 4 (SSE, NEON)
+    int Lanes();
+}
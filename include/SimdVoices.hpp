@@ -0,0 +1,75 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "Modules.hpp"
+#include "VoiceAllocator.hpp"
+#include "VoiceLanes.hpp"
+
+// Polyphonic subtractive voices that share one patch: oscillator, gain envelope and
+// lowpass per voice, with a filter envelope and lfo modulating the cutoff. The state 
+// of all voices is stored in structure-of-arrays lanes, so voices are processed 4, 8 
+// or 16 per instruction depending on the cpu.
+class SimdVoices final : public Module
+{
+public:
+    struct Settings
+    {
+        int voices = 8;
+        int lanes = 0; // Lanes per instruction, 0 picks the widest the cpu supports
+        VoiceAllocator::Policy stealing = VoiceAllocator::ReleasingFirst;
+        Wavetable wavetable = Wavetables::saw;
+        ADSR::Settings gain{};
+        ADSR::Settings filter{};
+
+        struct
+        {
+            double frequency = 0.5;
+            double envelope = 0; // Added to the frequency, scaled by the filter envelope
+            Wavetable wavetable = Wavetables::sine;
+        } lfo{};
+
+        struct
+        {
+            double frequency = 2000;
+            double envelope = 0; // Added to the cutoff, scaled by the squared filter envelope
+            double lfo = 0;      // Added to the cutoff, scaled by the lfo
+            double resonance = 1;
+            double mix = 1;
+        } lowpass{};
+    } settings;
+
+    SimdVoices() { Init(); }
+    SimdVoices(const Settings& s) : settings(s) { Init(); }
+
+    void Prepare(double sampleRate, int maxBlockSize, int channels) override;
+    void NotePress(int note, int velocity);
+    void NoteRelease(int note);
+
+    // Adds the mixed voices to every channel
+    void Generate() override;
+    Sample Apply(Sample s, Channel) override { return s + m_Sample; }
+    void ProcessBlock(std::span<Sample> block, int channels) override;
+
+    int Lanes() const { return m_Lanes; }
+    int Active() const;
+
+private:
+    constexpr static int MAX_LANES = 16;
+
+    int m_Lanes = 4;
+    Sample m_Sample = 0;
+    VoiceLanes m_State;
+    std::vector<float> m_Floats;
+    std::vector<int> m_Ints;
+    std::vector<float> m_Mix;
+    std::shared_ptr<const MipmapWavetable> m_Tables;
+    std::shared_ptr<const MipmapWavetable> m_LfoTables;
+
+    VoiceAllocator m_Allocator;
+
+    void Init();
+    void Update();
+    void Gate(VoiceLanes::Envelope& env, const ADSR::Settings& settings, int voice, bool gate);
+    void Render(float* out, int frames);
+};
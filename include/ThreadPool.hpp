@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Worker pool for the audio thread. A job runs a function for a range of indices, 
+// split in one part per thread; threads take from their own part first and steal
+// from the others when it's empty. Workers, and the thread waiting for the job,
+// spin for a while before parking, and running a job doesn't allocate or lock.
+class ThreadPool
+{
+public:
+    // Pool with threads - 1 workers, the thread that runs a job also takes part
+    ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Call fun(i) for every i in [0, count) and return when all calls are done
+    template<class Fun>
+    void Run(std::size_t count, Fun& fun)
+    {
+        m_Run(count, [](void* context, std::size_t i) { (*static_cast<Fun*>(context))(i); }, &fun);
+    }
+
+    int Threads() const { return m_Threads; }
+
+private:
+    struct alignas(64) Part
+    {
+        std::atomic<std::size_t> next = 0;
+        std::size_t end = 0;
+    };
+
+    int m_Threads;
+    std::unique_ptr<Part[]> m_Parts;
+    std::vector<std::thread> m_Workers;
+
+    // Odd while a job is being set up
+    alignas(64) std::atomic<std::uint32_t> m_Generation = 0;
+    alignas(64) std::atomic<int> m_Busy = 0;
+    alignas(64) std::atomic<std::uint32_t> m_Remaining = 0; // 32-bit so waiting on it is a plain futex
+    std::atomic<bool> m_Stop = false;
+
+    void (*m_Fun)(void*, std::size_t) = nullptr;
+    void* m_Context = nullptr;
+
+    void m_Run(std::size_t count, void (*fun)(void*, std::size_t), void* context);
+    void m_Work(int thread);
+    void m_Worker(int thread);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <typeinfo>
+
+// Timeline of begin, end and instant events, exported as chrome trace event json for
+// Perfetto or chrome://tracing. Every thread records into its own ring buffer that is
+// allocated by Start, so recording doesn't lock or allocate and the oldest events are
+// overwritten. Without SYNTHMAKR_TRACE recording compiles to nothing.
+class Trace
+{
+public:
+#ifdef SYNTHMAKR_TRACE
+    constexpr static bool ENABLED = true;
+#else
+    constexpr static bool ENABLED = false;
+#endif
+
+    struct Settings
+    {
+        int threads = 8;                 // Threads that get a ring, events of other threads are dropped
+        std::size_t events = 1 << 18;    // Per thread, rounded up to a power of two
+    };
+
+    // Allocate the rings and start recording, a trace with the same settings reuses the
+    // rings of the last one. Other threads may be processing unless the settings changed.
+    static void Start(const Settings& settings);
+    static void Start();
+
+    // Stop recording, events already recorded can be written
+    static void Stop();
+
+    // Write the recorded events as chrome trace json, after Stop
+    static bool Write(std::ostream& out);
+
+    // Name of the calling thread in the trace, the name must outlive the trace
+    static void Name(const char* name);
+
+    // Names must be string literals, they're kept until the trace is written
+    static void Begin(const char* name) { if constexpr (ENABLED) if (m_Recording.load(std::memory_order_acquire)) m_Record(name, 'B'); }
+    static void End(const char* name) { if constexpr (ENABLED) if (m_Recording.load(std::memory_order_acquire)) m_Record(name, 'E'); }
+    static void Instant(const char* name, int value) { if constexpr (ENABLED) if (m_Recording.load(std::memory_order_acquire)) m_Record(name, 'i', value); }
+
+    // Begin and end event around a scope, with a type name when tracing modules
+    class Scope
+    {
+    public:
+        Scope(const char* name) : m_Name(name) { Begin(name); }
+        Scope(const std::type_info& type) : m_Name(type.name()), m_Type(true) { m_Event('B'); }
+        ~Scope() { m_Type ? m_Event('E') : End(m_Name); }
+
+    private:
+        const char* m_Name;
+        bool m_Type = false;
+
+        void m_Event(char phase)
+        {
+            if constexpr (ENABLED)
+                if (m_Recording.load(std::memory_order_acquire))
+                    m_Record(m_Name, phase, 0, true);
+        }
+    };
+
+private:
+    static inline std::atomic<bool> m_Recording = false;
+
+    static void m_Record(const char* name, char phase, int value = 0, bool type = false);
+};
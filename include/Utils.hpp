@@ -1,5 +1,6 @@
 #pragma once
-#include "pch.hpp"
+#include <cmath>
+#include <map>
 
 static inline std::map<int, int> keyboard2midi = {
     { 90,  0  }, { 188, 12 }, { 81,  12 + 0  }, { 73,  12 + 12 }, // C
@@ -21,5 +22,5 @@ inline float noteToFreq(int note) { return (440. / 32.) * pow(2, ((note - 9) / 1
 using Sample = float;
 using Channel = int;
 
-#define db2lin(db) std::powf(10.0f, 0.05 * (db))
-#define lin2db(lin) (20.0f * std::log10f(static_cast<float>(lin)))
+#define db2lin(db) std::pow(10.0f, 0.05f * static_cast<float>(db))
+#define lin2db(lin) (20.0f * std::log10(static_cast<float>(lin)))
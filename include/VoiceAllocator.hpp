@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Assigns notes to a fixed number of voices. Voices are kept in intrusive lists per 
+// state, and held voices also per note, so presses and releases take constant time. 
+// Silent voices are used first, when there are none a voice is stolen by the policy.
+class VoiceAllocator
+{
+public:
+    enum Policy
+    {
+        Oldest,         // The voice that started longest ago
+        Quietest,       // The voice with the lowest level, scans all voices
+        SameNote,       // Retrigger a voice playing the same note, otherwise the oldest
+        ReleasingFirst, // The oldest released voice, otherwise the oldest held voice
+    };
+
+    struct Settings
+    {
+        Policy policy = ReleasingFirst; // Same order the voice bank always used
+    } settings;
+
+    VoiceAllocator() { m_Last.fill(-1); }
+    VoiceAllocator(const Settings& s) : settings(s) { m_Last.fill(-1); }
+
+    // Add voices, new voices are silent
+    void Voices(int count);
+    int Voices() const { return static_cast<int>(m_Voices.size()); }
+
+    // Pick a voice for a note, level(voice) gives the current level of a 
+    // voice and is only called by the quietest policy.
+    template<class Level>
+    int Press(int note, Level&& level)
+    {
+        int _voice = m_Retrigger(note);
+        if (_voice == -1)
+            _voice = m_Idle.tail;
+
+        if (_voice == -1 && settings.policy == Quietest)
+        {
+            float _quietest = 0;
+            for (auto _list : { &m_Held, &m_Releasing })
+                for (int i = _list->head; i != -1; i = m_Voices[i].state.next)
+                    if (float _level = level(i); _voice == -1 || _level < _quietest)
+                        _voice = i, _quietest = _level;
+        }
+
+        if (_voice == -1)
+            _voice = m_Steal();
+
+        if (_voice != -1)
+            m_Press(_voice, note);
+        return _voice;
+    }
+
+    // Release all voices that hold the note, calls release(voice) for each
+    template<class Fun>
+    void Release(int note, Fun&& release)
+    {
+        List& _notes = m_Notes[note & 127];
+        while (_notes.head != -1)
+        {
+            int _voice = _notes.head;
+            m_Release(_voice);
+            release(_voice);
+        }
+    }
+
+    // The voice went silent after it was released
+    void Done(int voice);
+
+    // Note held by a voice, -1 when it isn't held
+    int Note(int voice) const { return m_Voices[voice].held ? m_Voices[voice].note : -1; }
+
+private:
+    struct Links
+    {
+        int prev = -1;
+        int next = -1;
+    };
+
+    struct List
+    {
+        int head = -1; // Newest
+        int tail = -1; // Oldest
+    };
+
+    enum State : std::uint8_t { Idle, Held, Releasing };
+
+    struct Voice
+    {
+        Links state; // In the list of its state
+        Links notes; // In the list of its note while held
+        int note = -1;
+        std::uint64_t start = 0;
+        State current = Idle;
+        bool held = false;
+    };
+
+    std::vector<Voice> m_Voices;
+    std::array<List, 128> m_Notes;
+    std::array<int, 128> m_Last; // Last voice that played a note
+    List m_Idle;
+    List m_Held;
+    List m_Releasing;
+    std::uint64_t m_Counter = 0;
+
+    List& m_List(State state);
+    void m_Link(List& list, int voice, Links Voice::* links);
+    void m_Unlink(List& list, int voice, Links Voice::* links);
+    void m_Move(int voice, State state);
+
+    int m_Retrigger(int note);
+    int m_Steal();
+    void m_Press(int voice, int note);
+    void m_Release(int voice);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+// Lane state and parameters shared with the simd voice kernels. Kernels are compiled 
+// for several instruction sets, so this only contains plain data and raw pointers.
+struct VoiceLanes
+{
+    constexpr static int TABLE_SIZE = 2048; // MipmapWavetable::SIZE
+
+    struct Envelope
+    {
+        float* time;   // samples since the trigger, -1 when idle
+        float* level;
+        float* down;   // level when the gate was released
+        float* gate;   // 1 while held, 0 otherwise
+    };
+
+    struct EnvelopeParams
+    {
+        float attack, decay, sustain, release; // samples
+        float attackCurve, decayCurve, releaseCurve;
+    };
+
+    int count = 0; // lanes, a multiple of the widest lane count
+
+    // Oscillator
+    float* phase;
+    float* delta;
+    int* table;    // offset of the first of the 2 blended tables
+    float* blend;
+
+    Envelope gain;
+    Envelope filter;
+
+    // Lfo and lowpass
+    float* lfoPhase;
+    float* z1;
+    float* z2;
+
+    // Shared parameters
+    const float* tables;    // Mip-mapped oscillator tables
+    const float* lfoTable;  // Lfo table, band-limiting doesn't matter at lfo rates
+    EnvelopeParams gainParams;
+    EnvelopeParams filterParams;
+    float sampleRate;
+    float lfoFrequency, lfoEnvelope;
+    float cutoff, cutoffEnvelope, cutoffLfo, resonance, mix;
+};
+
+// Render frames of all lanes from first to last (exclusive), adding the mixed
+// voices to out. Every width processes that many lanes per instruction.
+void ProcessVoiceLanes4(VoiceLanes& lanes, int first, int last, float* out, int frames);
+void ProcessVoiceLanes8(VoiceLanes& lanes, int first, int last, float* out, int frames);
+void ProcessVoiceLanes16(VoiceLanes& lanes, int first, int last, float* out, int frames);
@@ -3,6 +3,7 @@
 #include <any>
 #include <ranges>
 #include <numbers>
+#include <span>
 
 #include "GuiCode2/pch.hpp"
 #include "GuiCode2/Components/Panel.hpp"
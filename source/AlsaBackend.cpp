@@ -0,0 +1,198 @@
+#include "Backends.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#include <alsa/asoundlib.h>
+#include <poll.h>
+
+namespace
+{
+    // Blocking interleaved float playback on its own thread, notes from an alsa
+    // sequencer port that other clients can connect to.
+    class AlsaBackend : public Backend
+    {
+    public:
+        using Backend::Backend;
+        ~AlsaBackend() override { Stop(); }
+
+        std::vector<Device> Devices() override
+        {
+            std::vector<Device> _devices;
+            void** _hints = nullptr;
+            if (snd_device_name_hint(-1, "pcm", &_hints) < 0)
+                return _devices;
+
+            for (void** i = _hints; *i; i++)
+            {
+                char* _name = snd_device_name_get_hint(*i, "NAME");
+                char* _description = snd_device_name_get_hint(*i, "DESC");
+                char* _direction = snd_device_name_get_hint(*i, "IOID"); // nullptr for both directions
+                if (_name && (!_direction || std::string{ _direction } == "Output"))
+                    _devices.push_back({ _name, _description ? _description : _name });
+                std::free(_name), std::free(_description), std::free(_direction);
+            }
+
+            snd_device_name_free_hint(_hints);
+            return _devices;
+        }
+
+        bool Start(Engine& engine) override
+        {
+            Stop();
+            m_Format = settings;
+            if (!m_Open())
+                return Stop(), false;
+
+            engine.Prepare(m_Format.sampleRate, m_Format.bufferSize, m_Format.channels);
+            m_Buffer.assign(static_cast<std::size_t>(m_Format.bufferSize) * m_Format.channels, 0);
+            m_Xruns = 0;
+            m_Running = true;
+            m_Thread = std::thread{ [this, &engine] { m_Run(engine); } };
+
+            if (settings.midi && snd_seq_open(&m_Sequencer, "default", SND_SEQ_OPEN_INPUT, 0) == 0)
+            {
+                snd_seq_set_client_name(m_Sequencer, "SynthMakr");
+                snd_seq_create_simple_port(m_Sequencer, "Notes",
+                    SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                    SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+                m_Midi = std::thread{ [this, &engine] { m_Receive(engine); } };
+            }
+
+            return true;
+        }
+
+        void Stop() override
+        {
+            m_Running = false;
+            if (m_Thread.joinable())
+                m_Thread.join();
+            if (m_Midi.joinable())
+                m_Midi.join();
+
+            if (m_Pcm)
+                snd_pcm_close(m_Pcm), m_Pcm = nullptr;
+            if (m_Sequencer)
+                snd_seq_close(m_Sequencer), m_Sequencer = nullptr;
+        }
+
+    private:
+        snd_pcm_t* m_Pcm = nullptr;
+        snd_seq_t* m_Sequencer = nullptr;
+        std::vector<Sample> m_Buffer;
+        std::atomic<bool> m_Running = false;
+        std::thread m_Thread;
+        std::thread m_Midi;
+
+        bool m_Open()
+        {
+            const char* _device = settings.device.empty() ? "default" : settings.device.c_str();
+            if (snd_pcm_open(&m_Pcm, _device, SND_PCM_STREAM_PLAYBACK, 0) < 0)
+                return false;
+
+            // The device picks the nearest format it supports
+            snd_pcm_hw_params_t* _hw;
+            snd_pcm_hw_params_alloca(&_hw);
+            unsigned int _rate = static_cast<unsigned int>(settings.sampleRate);
+            unsigned int _periods = static_cast<unsigned int>(std::max(settings.periods, 2));
+            snd_pcm_uframes_t _period = static_cast<snd_pcm_uframes_t>(settings.bufferSize > 0 ? settings.bufferSize : DEFAULT_BUFFER_SIZE);
+            if (snd_pcm_hw_params_any(m_Pcm, _hw) < 0
+                || snd_pcm_hw_params_set_access(m_Pcm, _hw, SND_PCM_ACCESS_RW_INTERLEAVED) < 0
+                || snd_pcm_hw_params_set_format(m_Pcm, _hw, SND_PCM_FORMAT_FLOAT) < 0
+                || snd_pcm_hw_params_set_channels(m_Pcm, _hw, settings.channels) < 0
+                || snd_pcm_hw_params_set_rate_near(m_Pcm, _hw, &_rate, nullptr) < 0
+                || snd_pcm_hw_params_set_period_size_near(m_Pcm, _hw, &_period, nullptr) < 0
+                || snd_pcm_hw_params_set_periods_near(m_Pcm, _hw, &_periods, nullptr) < 0
+                || snd_pcm_hw_params(m_Pcm, _hw) < 0)
+                return false;
+
+            // Wake up for every period, start playing once all periods are queued
+            snd_pcm_sw_params_t* _sw;
+            snd_pcm_sw_params_alloca(&_sw);
+            if (snd_pcm_sw_params_current(m_Pcm, _sw) < 0
+                || snd_pcm_sw_params_set_avail_min(m_Pcm, _sw, _period) < 0
+                || snd_pcm_sw_params_set_start_threshold(m_Pcm, _sw, _period * _periods) < 0
+                || snd_pcm_sw_params(m_Pcm, _sw) < 0)
+                return false;
+
+            m_Format.sampleRate = _rate;
+            m_Format.bufferSize = static_cast<int>(_period);
+            m_Format.periods = static_cast<int>(_periods);
+            return snd_pcm_prepare(m_Pcm) == 0;
+        }
+
+        void m_Run(Engine& engine)
+        {
+            RealtimePriority();
+            Trace::Name("Alsa");
+
+            while (m_Running.load(std::memory_order_relaxed))
+            {
+                engine.Process(m_Buffer, m_Format.channels);
+
+                const Sample* _data = m_Buffer.data();
+                snd_pcm_uframes_t _frames = m_Format.bufferSize;
+                while (_frames > 0 && m_Running.load(std::memory_order_relaxed))
+                {
+                    snd_pcm_sframes_t _written = snd_pcm_writei(m_Pcm, _data, _frames);
+                    if (_written == -EPIPE)
+                    {
+                        // Ran out of samples, start over with this buffer
+                        m_Xruns++;
+                        snd_pcm_prepare(m_Pcm);
+                    }
+                    else if (_written < 0)
+                    {
+                        if (snd_pcm_recover(m_Pcm, static_cast<int>(_written), 1) < 0)
+                            return;
+                    }
+                    else
+                    {
+                        _data += _written * m_Format.channels;
+                        _frames -= _written;
+                    }
+                }
+            }
+
+            snd_pcm_drop(m_Pcm);
+        }
+
+        void m_Receive(Engine& engine)
+        {
+            Trace::Name("Alsa midi");
+
+            // Poll with a timeout, so the thread sees when it's stopped
+            std::vector<pollfd> _fds(snd_seq_poll_descriptors_count(m_Sequencer, POLLIN));
+            snd_seq_poll_descriptors(m_Sequencer, _fds.data(), _fds.size(), POLLIN);
+            while (m_Running.load(std::memory_order_relaxed))
+            {
+                if (poll(_fds.data(), _fds.size(), 100) <= 0)
+                    continue;
+
+                snd_seq_event_t* _event = nullptr;
+                while (snd_seq_event_input(m_Sequencer, &_event) >= 0 && _event)
+                {
+                    bool _press = _event->type == SND_SEQ_EVENT_NOTEON && _event->data.note.velocity > 0;
+                    bool _release = _event->type == SND_SEQ_EVENT_NOTEOFF
+                        || (_event->type == SND_SEQ_EVENT_NOTEON && _event->data.note.velocity == 0);
+
+                    if (_press || _release)
+                        engine.Send({
+                            .type = _press ? Engine::Event::Press : Engine::Event::Release,
+                            .note = _event->data.note.note,
+                            .velocity = _event->data.note.velocity,
+                        });
+
+                    if (snd_seq_event_input_pending(m_Sequencer, 0) == 0)
+                        break;
+                }
+            }
+        }
+    };
+}
+
+std::unique_ptr<Backend> MakeAlsaBackend(const Backend::Settings& settings)
+{
+    return std::make_unique<AlsaBackend>(settings);
+}
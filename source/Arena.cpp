@@ -0,0 +1,38 @@
+#include "Arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+Arena::~Arena()
+{
+    for (auto _it = m_Destructors.rbegin(); _it != m_Destructors.rend(); ++_it)
+        _it->destroy(_it->object);
+
+    for (auto& i : m_Blocks)
+        ::operator delete(i, std::align_val_t{ CACHE_LINE });
+}
+
+void* Arena::Allocate(std::size_t size, std::size_t align)
+{
+    auto _aligned = [&](std::byte* p) {
+        auto _address = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((align - _address % align) % align);
+    };
+
+    std::byte* _start = m_Next ? _aligned(m_Next) : nullptr;
+    if (!_start || _start + size > m_End)
+    {
+        // Blocks are cache line aligned, so larger alignments need room to align
+        std::size_t _size = std::max(m_BlockSize, size + align);
+        auto _block = static_cast<std::byte*>(::operator new(_size, std::align_val_t{ CACHE_LINE }));
+        m_Blocks.push_back(_block);
+        m_Used += m_Next ? m_End - m_Next : 0; // Rest of the previous block is lost
+        m_Next = _block;
+        m_End = _block + _size;
+        _start = _aligned(m_Next);
+    }
+
+    m_Used += _start + size - m_Next;
+    m_Next = _start + size;
+    return _start;
+}
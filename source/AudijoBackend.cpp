@@ -0,0 +1,127 @@
+#include "AudijoBackend.hpp"
+
+AudijoBackend::AudijoBackend(const Settings& s)
+    : Backend(s)
+{
+    m_Midi.Callback([this](const NoteOn& e) {
+        Trace::Name("Midi");
+        m_Engine->Send({ .type = Engine::Event::Press, .note = e.RawNote(), .velocity = e.Velocity() });
+    });
+
+    m_Midi.Callback([this](const NoteOff& e) {
+        Trace::Name("Midi");
+        m_Engine->Send({ .type = Engine::Event::Release, .note = e.RawNote(), .velocity = e.Velocity() });
+    });
+
+    m_Stream.Callback([&](Buffer<Sample>&, Buffer<Sample>& out, CallbackInfo info)
+    {
+        Trace::Name("Audio");
+
+        int _frames = 0, _channels = 0;
+        for (auto& i : out)
+        {
+            _channels = 0;
+            for (auto& j : i)
+                _channels++;
+            _frames++;
+        }
+
+        // The engine was prepared for the format the stream opened with, on any
+        // other format output silence, preparing again here would allocate.
+        if (m_Block.empty() || _channels != m_Format.channels || info.sampleRate != m_Format.sampleRate)
+        {
+            for (auto& i : out)
+                for (auto& j : i)
+                    j = 0;
+            return;
+        }
+
+        // Render the buffer in interleaved blocks of the prepared size, nothing is
+        // allocated here.
+        std::size_t _max = m_Block.size() / _channels;
+        auto _frame = out.begin();
+        for (std::size_t i = 0; i < _frames; i += _max)
+        {
+            std::size_t _size = std::min<std::size_t>(_max, _frames - i);
+            std::span<Sample> _block{ m_Block.data(), _size * _channels };
+            m_Engine->Process(_block, _channels);
+
+            auto _it = _block.begin();
+            for (std::size_t j = 0; j < _size; j++, ++_frame)
+                for (auto& k : *_frame)
+                    k = *_it++;
+        }
+    });
+}
+
+std::vector<Backend::Device> AudijoBackend::Devices()
+{
+    std::vector<Device> _devices;
+    for (auto& i : m_Stream.Devices())
+        if (i.outputChannels)
+            _devices.push_back({ std::to_string(i.id), i.name });
+    return _devices;
+}
+
+std::vector<Backend::Device> AudijoBackend::MidiDevices()
+{
+    std::vector<Device> _devices;
+    for (auto& i : m_Midi.Devices())
+        _devices.push_back({ std::to_string(i.id), i.name });
+    return _devices;
+}
+
+bool AudijoBackend::OpenMidi(const std::string& device)
+{
+    // Opened by Start when the audio isn't running
+    settings.midiDevice = device;
+    if (!m_Engine || !settings.midi)
+        return false;
+
+    m_Midi.Close();
+    for (auto& i : m_Midi.Devices())
+        if (device.empty() || std::to_string(i.id) == device)
+            return m_Midi.Open({ .device = i.id }) == Midijo::NoError;
+    return false;
+}
+
+bool AudijoBackend::Start(Engine& engine)
+{
+    Stop();
+    for (auto& i : m_Stream.Devices())
+    {
+        // No device in the settings plays on the first output
+        if (!i.outputChannels || (!settings.device.empty() && std::to_string(i.id) != settings.device))
+            continue;
+
+        m_Format = settings;
+        m_Engine = &engine;
+        if (m_Stream.Open({
+            .input = NoDevice,
+            .output = i.id,
+            .bufferSize = m_Format.bufferSize,
+            .sampleRate = m_Format.sampleRate,
+        }) != NoError)
+            return false;
+
+        // The device can open with another rate or buffer size than asked for,
+        // prepare for what it opened with before the stream starts, so the
+        // callback never allocates.
+        m_Format.sampleRate = m_Stream.SampleRate();
+        m_Format.bufferSize = m_Stream.BufferSize();
+        m_Format.channels = i.outputChannels;
+        engine.Prepare(m_Format.sampleRate, m_Format.bufferSize, m_Format.channels);
+        m_Block.assign(static_cast<std::size_t>(m_Format.bufferSize) * m_Format.channels, 0);
+        m_Stream.Start();
+        OpenMidi(settings.midiDevice);
+        return true;
+    }
+
+    return false;
+}
+
+void AudijoBackend::Stop()
+{
+    m_Midi.Close();
+    m_Stream.Close();
+}
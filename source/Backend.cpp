@@ -0,0 +1,53 @@
+#include "Backends.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    struct Entry
+    {
+        const char* name;
+        std::unique_ptr<Backend>(*make)(const Backend::Settings&);
+    };
+
+    // Best backend first
+    constexpr Entry backends[]{
+#ifdef SYNTHMAKR_JACK
+        { "jack", MakeJackBackend },
+#endif
+#ifdef SYNTHMAKR_ALSA
+        { "alsa", MakeAlsaBackend },
+#endif
+        { "null", MakeNullBackend },
+    };
+}
+
+std::vector<std::string> Backend::Names()
+{
+    std::vector<std::string> _names;
+    for (auto& i : backends)
+        _names.push_back(i.name);
+    return _names;
+}
+
+std::unique_ptr<Backend> Backend::Create(const std::string& name, const Settings& settings)
+{
+    for (auto& i : backends)
+        if (name == i.name)
+            return i.make(settings);
+    return nullptr;
+}
+
+bool RealtimePriority()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    sched_param _param{};
+    _param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 10;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &_param) == 0;
+#else
+    return false;
+#endif
+}
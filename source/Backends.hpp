@@ -0,0 +1,11 @@
+#pragma once
+#include "Backend.hpp"
+
+// Backend implementations, one translation unit each. Alsa and jack are only
+// built when cmake finds their libraries.
+std::unique_ptr<Backend> MakeNullBackend(const Backend::Settings& settings);
+std::unique_ptr<Backend> MakeAlsaBackend(const Backend::Settings& settings);
+std::unique_ptr<Backend> MakeJackBackend(const Backend::Settings& settings);
+
+// Run the calling thread with real-time priority, false when the system doesn't allow it
+bool RealtimePriority();
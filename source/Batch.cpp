@@ -0,0 +1,63 @@
+#include "Batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "MidiFile.hpp"
+#include "Modules.hpp"
+#include "ThreadPool.hpp"
+
+std::vector<Batch::Result> Batch::Run(std::span<const Job> jobs)
+{
+    std::vector<Result> _results(jobs.size());
+
+    ThreadPool _pool{ Threads(jobs.size()) };
+    auto _render = [&](std::size_t i) { _results[i] = m_Render(jobs[i]); };
+    _pool.Run(jobs.size(), _render);
+    return _results;
+}
+
+int Batch::Threads(std::size_t jobs) const
+{
+    int _threads = settings.threads > 0 ? settings.threads : std::max<int>(std::thread::hardware_concurrency(), 1);
+    return std::min<std::size_t>(_threads, std::max<std::size_t>(jobs, 1));
+}
+
+Batch::Result Batch::m_Render(const Job& job)
+{
+    Result _result;
+    auto _start = std::chrono::steady_clock::now();
+
+    Renderer _renderer{ settings.render };
+    if (job.sampleRate > 0)
+        _renderer.settings.sampleRate = job.sampleRate;
+    _result.sampleRate = _renderer.settings.sampleRate;
+
+    // Midi files are streamed like the events
+    Renderer::Source _source;
+    MidiFile _midi;
+    if (job.midi.empty())
+        _source = _renderer.Events(job.events);
+    else if (_midi.Open(job.midi, _result.sampleRate))
+        _source = [&](Engine::Event& e) { return _midi.Next(e); };
+    else
+        return _result.error = "can't open midi file: " + job.midi, _result;
+
+    WavWriter _wav;
+    if (!job.output.empty() && !_wav.Open(job.output, settings.render.channels, _result.sampleRate))
+        return _result.error = "can't write output: " + job.output, _result;
+
+    auto _engine = job.engine();
+    bool _written = true;
+    _result.frames = _renderer.Render(*_engine, _source, [&](std::span<const Sample> block) {
+        if (!job.output.empty())
+            _written = _wav.Write(block) && _written;
+    });
+
+    if (!job.output.empty() && !(_wav.Close() && _written))
+        _result.error = "can't write output: " + job.output;
+
+    _result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    return _result;
+}
@@ -0,0 +1,246 @@
+#include "Engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    std::int64_t Nanoseconds()
+    {
+        auto _now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(_now).count();
+    }
+}
+
+void Engine::VoiceBase::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    m_SampleRate = sampleRate;
+    m_Buffer.assign(static_cast<std::size_t>(maxBlockSize) * channels, 0);
+    m_Rendered = 0;
+    for (auto& i : m_Modules)
+        i->Prepare(sampleRate, maxBlockSize, channels);
+}
+
+void Engine::VoiceBase::Render(std::size_t samples, int channels)
+{
+    m_Render(samples, channels, m_Chain);
+}
+
+void Engine::VoiceBase::Process(std::span<Sample> block, int channels)
+{
+    Render(block.size(), channels);
+    for (std::size_t i = 0; i < block.size(); i++)
+        block[i] += m_Buffer[i];
+}
+
+void Engine::VoiceBank::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    m_Format = { sampleRate, maxBlockSize, channels };
+    for (auto& i : m_GeneratorVoices)
+        i->Prepare(sampleRate, maxBlockSize, channels);
+}
+
+void Engine::VoiceBank::NotePress(int note, int velocity)
+{
+    Trace::Instant("NotePress", note);
+    int _voice = m_Allocator.Press(note, [&](int i) { return m_GeneratorVoices[i]->Level(); });
+    if (_voice == -1)
+        return;
+
+    // Voices that are still sounding were stolen
+    if (!m_GeneratorVoices[_voice]->Done())
+        Trace::Instant("Steal", _voice);
+    m_GeneratorVoices[_voice]->NotePress(note, velocity);
+}
+
+void Engine::VoiceBank::NoteRelease(int note, int)
+{
+    Trace::Instant("NoteRelease", note);
+    m_Allocator.Release(note, [&](int i) { m_GeneratorVoices[i]->NoteRelease(note); });
+}
+
+bool Engine::VoiceBank::m_Done(std::size_t voice)
+{
+    if (!m_GeneratorVoices[voice]->Done())
+        return false;
+
+    m_Allocator.Done(voice);
+    return true;
+}
+
+void Engine::VoiceBank::Process(std::span<Sample> block, int channels)
+{
+    Trace::Scope _trace{ "VoiceBank::Process" };
+    Realtime::Scope _realtime;
+    m_Active.clear();
+    for (std::size_t i = 0; i < m_GeneratorVoices.size(); i++)
+        if (!m_Done(i))
+            m_Active.push_back(m_GeneratorVoices[i]);
+    m_Playing = m_Active.size();
+
+    // Waking the workers costs more than a few voices or a short block take to render
+    if (!m_Pool || m_Active.size() < PARALLEL_VOICES || block.size() / channels < PARALLEL_FRAMES)
+    {
+        for (auto& voice : m_Active)
+            voice->Process(block, channels);
+        return;
+    }
+
+    auto _render = [&](std::size_t i) { m_Active[i]->Render(block.size(), channels); };
+    m_Pool->Run(m_Active.size(), _render);
+
+    // Mix in voice order, same as the serial path
+    for (auto& voice : m_Active)
+    {
+        auto _output = voice->Output();
+        for (std::size_t i = 0; i < block.size(); i++)
+            block[i] += _output[i];
+    }
+}
+
+void Engine::VoiceBank::Threads(int threads)
+{
+    m_Pool = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+}
+
+void Engine::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    // The chain is built here, building it allocates
+    if (!m_Chain)
+        m_Chain = Chain();
+
+    m_SampleRate = sampleRate;
+    m_BlockSize = std::max(maxBlockSize, 1);
+    m_Channels = channels;
+    m_Monitor.Restart();
+
+    for (auto& i : m_Modules)
+        i->Prepare(sampleRate, m_BlockSize, channels);
+    m_Voices.Prepare(sampleRate, m_BlockSize, channels);
+}
+
+bool Engine::Send(Event e)
+{
+    // Shows note bursts from the gui and midi threads in a trace
+    Trace::Instant("Send", e.note);
+    if (e.frame < 0)
+        e.frame = m_Now();
+
+    return m_Events.Push(e);
+}
+
+std::int64_t Engine::m_Now() const
+{
+    std::uint32_t _sequence;
+    std::int64_t _frame, _time, _latency;
+    double _sampleRate;
+    do
+    {
+        _sequence = m_Clock.sequence.load(std::memory_order_acquire);
+        _frame = m_Clock.frame.load(std::memory_order_relaxed);
+        _time = m_Clock.time.load(std::memory_order_relaxed);
+        _latency = m_Clock.latency.load(std::memory_order_relaxed);
+        _sampleRate = m_Clock.sampleRate.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } 
+    while ((_sequence & 1) || _sequence != m_Clock.sequence.load(std::memory_order_relaxed));
+
+    // Nothing rendered yet, play at the first block
+    if (_time == 0)
+        return _frame;
+
+    // Place the event in the next block, at the same offset it was sent in the current one
+    std::int64_t _elapsed = (Nanoseconds() - _time) * _sampleRate / 1e9;
+    return _frame + _latency + std::max<std::int64_t>(_elapsed, 0);
+}
+
+void Engine::m_Publish(std::int64_t frames)
+{
+    std::uint32_t _sequence = m_Clock.sequence.load(std::memory_order_relaxed);
+    m_Clock.sequence.store(_sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_Clock.frame.store(m_Frame, std::memory_order_relaxed);
+    m_Clock.time.store(Nanoseconds(), std::memory_order_relaxed);
+    m_Clock.latency.store(frames, std::memory_order_relaxed);
+    m_Clock.sampleRate.store(m_SampleRate, std::memory_order_relaxed);
+
+    m_Clock.sequence.store(_sequence + 2, std::memory_order_release);
+}
+
+void Engine::m_Receive()
+{
+    // Keep pending events sorted latest first, events on the same frame in the order they were sent
+    Event _event;
+    while (m_Pending.size() < MAX_EVENTS && m_Events.Pop(_event))
+    {
+        auto _it = std::lower_bound(m_Pending.begin(), m_Pending.end(), _event,
+            [](const Event& a, const Event& b) { return a.frame > b.frame; });
+        m_Pending.insert(_it, _event);
+    }
+}
+
+std::int64_t Engine::m_Dispatch(std::int64_t frame)
+{
+    // Handle all events up to the frame, late events are handled right away
+    while (!m_Pending.empty() && m_Pending.back().frame <= frame)
+    {
+        Event& _event = m_Pending.back();
+        if (_event.type == Event::Press)
+            NotePress(_event.note, _event.velocity);
+        else
+            NoteRelease(_event.note, _event.velocity);
+        m_Pending.pop_back();
+    }
+
+    return m_Pending.empty() ? std::numeric_limits<std::int64_t>::max() : m_Pending.back().frame;
+}
+
+void Engine::Process(std::span<Sample> block, int channels)
+{
+    // Preparing allocates, so it's done by the caller off the audio thread
+    assert(m_BlockSize > 0 && channels == m_Channels && "Engine wasn't prepared for this channel count");
+    if (m_BlockSize == 0 || channels != m_Channels)
+    {
+        std::fill(block.begin(), block.end(), 0);
+        return;
+    }
+
+    // Measure the whole call, it's the block the device asked for
+    std::int64_t _frames = block.size() / channels;
+    Trace::Scope _trace{ "Engine::Process" };
+    m_Monitor.Begin(_frames, m_SampleRate);
+    for (std::int64_t i = 0; i < _frames; i += m_BlockSize)
+        m_Process(block.subspan(i * channels, std::min<std::int64_t>(m_BlockSize, _frames - i) * channels), channels);
+    m_Monitor.End(m_Voices.Playing());
+}
+
+void Engine::m_Process(std::span<Sample> block, int channels)
+{
+    Realtime::Scope _realtime;
+    std::int64_t _frames = block.size() / channels;
+    m_Publish(_frames);
+    m_Receive();
+
+    for (auto& i : m_Params)
+        i.Advance(_frames, m_SampleRate);
+
+    std::fill(block.begin(), block.end(), 0);
+
+    // Render until the next event or the end of the block
+    std::int64_t _frame = 0;
+    while (_frame < _frames)
+    {
+        std::int64_t _next = std::min(m_Dispatch(m_Frame + _frame) - m_Frame, _frames);
+        std::span<Sample> _part = block.subspan(_frame * channels, (_next - _frame) * channels);
+        m_Voices.Process(_part, channels);
+
+        // The master modules are generated by the chain, so modulation happens once per part.
+        Mod();
+        m_Chain(_part, channels);
+        _frame = _next;
+    }
+
+    m_Frame += _frames;
+}
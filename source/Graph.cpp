@@ -0,0 +1,196 @@
+#include "Graph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <queue>
+
+Graph::Node Graph::Add(ChainFun stage, std::initializer_list<Input> inputs)
+{
+#ifndef NDEBUG
+    for (auto& i : inputs)
+        assert(i.node.index >= 0 && i.node.index < static_cast<int>(m_Nodes.size()) && "Input isn't a node of this graph");
+#endif
+
+    m_Nodes.push_back({ std::move(stage), inputs });
+    return { static_cast<int>(m_Nodes.size()) - 1 };
+}
+
+void Graph::Send(Node from, Node to, Sample gain)
+{
+    assert(from.index >= 0 && from.index < static_cast<int>(m_Nodes.size()) && "Send from a node of another graph");
+    assert(to.index > 0 && to.index < static_cast<int>(m_Nodes.size()) && "Send to a node of another graph");
+    m_Nodes[to.index].inputs.push_back({ from, gain });
+}
+
+void Graph::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+
+    int _nodes = static_cast<int>(m_Nodes.size());
+    int _output = m_Output >= 0 ? m_Output : _nodes - 1;
+
+    // Only nodes that reach the output are processed
+    std::vector<bool> _used(_nodes, false);
+    std::vector<int> _stack{ _output };
+    _used[_output] = true;
+    while (!_stack.empty())
+    {
+        int _node = _stack.back();
+        _stack.pop_back();
+        for (auto& i : m_Nodes[_node].inputs)
+            if (!_used[i.node.index])
+                _used[i.node.index] = true, _stack.push_back(i.node.index);
+    }
+
+    // Topological order, nodes that are ready go in the order they were added
+    std::vector<int> _waiting(_nodes, 0);
+    std::vector<std::vector<int>> _consumers(_nodes);
+    for (int i = 0; i < _nodes; i++)
+        if (_used[i])
+            for (auto& j : m_Nodes[i].inputs)
+                _waiting[i]++, _consumers[j.node.index].push_back(i);
+
+    std::priority_queue<int, std::vector<int>, std::greater<int>> _ready;
+    for (int i = 0; i < _nodes; i++)
+        if (_used[i] && _waiting[i] == 0)
+            _ready.push(i);
+
+    std::vector<int> _order;
+    while (!_ready.empty())
+    {
+        int _node = _ready.top();
+        _ready.pop();
+        _order.push_back(_node);
+        for (int i : _consumers[_node])
+            if (--_waiting[i] == 0)
+                _ready.push(i);
+    }
+
+    assert(_order.size() == static_cast<std::size_t>(std::count(_used.begin(), _used.end(), true)) && "Graph has a cycle");
+
+    // A buffer is live until the last node that reads it, the output until the end
+    std::vector<int> _position(_nodes, -1), _last(_nodes, -1);
+    for (std::size_t i = 0; i < _order.size(); i++)
+        _position[_order[i]] = static_cast<int>(i);
+    for (int i : _order)
+        for (auto& j : m_Nodes[i].inputs)
+            _last[j.node.index] = std::max(_last[j.node.index], _position[i]);
+    _last[_output] = std::numeric_limits<int>::max();
+
+    // The block holds the input, and is a free buffer when nothing reads the input
+    std::vector<int> _buffer(_nodes, -1), _free;
+    _buffer[0] = 0;
+    if (_last[0] < 0)
+        _free.push_back(0);
+
+    m_Schedule.clear();
+    m_Reads.clear();
+    m_Buffers = 0;
+    for (int _node : _order)
+    {
+        if (_node == 0)
+            continue;
+
+        // An input that is read more than once is read once with the gains summed, so
+        // processing in place never overwrites an input that is read again
+        std::vector<Input> _inputs;
+        for (auto& i : m_Nodes[_node].inputs)
+        {
+            auto _same = std::find_if(_inputs.begin(), _inputs.end(), [&](auto& j) { return j.node.index == i.node.index; });
+            if (_same == _inputs.end())
+                _inputs.push_back(i);
+            else
+                _same->gain += i.gain;
+        }
+
+        // Process in place in an input that isn't read after this node
+        int _p = _position[_node];
+        auto _reuse = std::find_if(_inputs.begin(), _inputs.end(), [&](auto& i) { return i.gain == 1 && _last[i.node.index] == _p; });
+
+        Step _step{ .node = _node, .inPlace = _reuse != _inputs.end(), .begin = m_Reads.size() };
+        if (_step.inPlace)
+            _step.buffer = _buffer[_reuse->node.index], m_Reads.push_back({ _step.buffer, 1 });
+        else if (!_free.empty())
+            _step.buffer = _free.back(), _free.pop_back();
+        else
+            _step.buffer = ++m_Buffers;
+
+        for (auto i = _inputs.begin(); i != _inputs.end(); ++i)
+            if (i != _reuse)
+                m_Reads.push_back({ _buffer[i->node.index], i->gain });
+        _step.end = m_Reads.size();
+        _buffer[_node] = _step.buffer;
+        m_Schedule.push_back(_step);
+
+        // Inputs read for the last time free their buffer
+        for (auto& i : _inputs)
+            if (_last[i.node.index] == _p && _buffer[i.node.index] != _step.buffer)
+                _free.push_back(_buffer[i.node.index]);
+    }
+
+    m_Result = _buffer[_output];
+    m_Size = static_cast<std::size_t>(maxBlockSize) * channels;
+    m_Scratch.assign(m_Size * m_Buffers, 0);
+    m_Values.assign(m_Buffers + 1, 0);
+}
+
+std::span<Sample> Graph::m_Buffer(std::span<Sample> block, int buffer)
+{
+    return buffer == 0 ? block : std::span<Sample>{ m_Scratch.data() + (buffer - 1) * m_Size, block.size() };
+}
+
+Sample Graph::Apply(Sample s, Channel c)
+{
+    m_Values[0] = s;
+    for (auto& i : m_Schedule)
+    {
+        Sample _sum = 0;
+        for (std::size_t j = i.begin; j < i.end; j++)
+            _sum += m_Reads[j].gain * m_Values[m_Reads[j].buffer];
+
+        auto& _stage = m_Nodes[i.node].stage;
+        m_Values[i.buffer] = _stage ? _stage(_sum, c) : _sum;
+    }
+    return m_Values[m_Result];
+}
+
+void Graph::ProcessBlock(std::span<Sample> block, int channels)
+{
+    assert(block.size() <= m_Size && "Graph wasn't prepared for this block size");
+    for (auto& i : m_Schedule)
+    {
+        // The first read is already in the output when processing in place
+        auto _out = m_Buffer(block, i.buffer);
+        std::size_t _read = i.begin;
+        if (!i.inPlace && _read == i.end)
+            std::fill(_out.begin(), _out.end(), 0);
+        else if (!i.inPlace)
+        {
+            auto _in = m_Buffer(block, m_Reads[_read].buffer);
+            Sample _gain = m_Reads[_read++].gain;
+            for (std::size_t j = 0; j < _out.size(); j++)
+                _out[j] = _in[j] * _gain;
+        }
+        else
+            _read++;
+
+        for (; _read < i.end; _read++)
+        {
+            auto _in = m_Buffer(block, m_Reads[_read].buffer);
+            Sample _gain = m_Reads[_read].gain;
+            for (std::size_t j = 0; j < _out.size(); j++)
+                _out[j] += _in[j] * _gain;
+        }
+
+        if (auto& _stage = m_Nodes[i.node].stage)
+            _stage(_out, channels);
+    }
+
+    if (m_Result != 0)
+    {
+        auto _result = m_Buffer(block, m_Result);
+        std::copy(_result.begin(), _result.end(), block.begin());
+    }
+}
@@ -0,0 +1,144 @@
+#include "Backends.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include <jack/jack.h>
+#include <jack/midiport.h>
+
+namespace
+{
+    // Jack client with an output port per channel and a midi input port. The buffer
+    // size is the one of the server, it is only changed when the settings ask for a 
+    // size, for the whole server. The periods are part of the server setup.
+    class JackBackend : public Backend
+    {
+    public:
+        using Backend::Backend;
+        ~JackBackend() override { Stop(); }
+
+        std::vector<Device> Devices() override { return { { "", "Jack" } }; }
+
+        bool Start(Engine& engine) override
+        {
+            Stop();
+            m_Format = settings;
+            m_Engine = &engine;
+
+            jack_status_t _status;
+            m_Client = jack_client_open("SynthMakr", JackNoStartServer, &_status);
+            if (!m_Client)
+                return false;
+
+            // Other clients of the server are resized as well, so only when asked for
+            if (settings.bufferSize > 0 && static_cast<jack_nframes_t>(settings.bufferSize) != jack_get_buffer_size(m_Client))
+                jack_set_buffer_size(m_Client, settings.bufferSize);
+
+            m_Format.sampleRate = jack_get_sample_rate(m_Client);
+            m_Format.bufferSize = jack_get_buffer_size(m_Client);
+            m_Format.periods = 0; // Unknown, set for the server
+            m_Format.channels = std::max(settings.channels, 1);
+
+            m_Ports.clear();
+            for (int i = 0; i < m_Format.channels; i++)
+            {
+                std::string _name = "out_" + std::to_string(i + 1);
+                m_Ports.push_back(jack_port_register(m_Client, _name.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0));
+            }
+
+            if (settings.midi)
+                m_MidiPort = jack_port_register(m_Client, "notes", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+
+            // Larger buffers are rendered in parts by the engine
+            engine.Prepare(m_Format.sampleRate, m_Format.bufferSize, m_Format.channels);
+            m_Buffer.assign(static_cast<std::size_t>(m_Format.bufferSize) * m_Format.channels, 0);
+            m_Xruns = 0;
+
+            jack_set_process_callback(m_Client, [](jack_nframes_t frames, void* self) {
+                return static_cast<JackBackend*>(self)->m_Process(frames);
+            }, this);
+
+            jack_set_xrun_callback(m_Client, [](void* self) {
+                static_cast<JackBackend*>(self)->m_Xruns++;
+                return 0;
+            }, this);
+
+            if (jack_activate(m_Client) != 0)
+                return Stop(), false;
+
+            // Play on the first physical outputs
+            if (const char** _outputs = jack_get_ports(m_Client, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput))
+            {
+                for (std::size_t i = 0; i < m_Ports.size() && _outputs[i]; i++)
+                    jack_connect(m_Client, jack_port_name(m_Ports[i]), _outputs[i]);
+                jack_free(_outputs);
+            }
+
+            return true;
+        }
+
+        void Stop() override
+        {
+            if (m_Client)
+                jack_client_close(m_Client), m_Client = nullptr;
+            m_MidiPort = nullptr;
+        }
+
+    private:
+        Engine* m_Engine = nullptr;
+        jack_client_t* m_Client = nullptr;
+        std::vector<jack_port_t*> m_Ports;
+        jack_port_t* m_MidiPort = nullptr;
+        std::vector<Sample> m_Buffer;
+
+        int m_Process(jack_nframes_t frames)
+        {
+            Trace::Name("Jack");
+            int _channels = m_Format.channels;
+
+            // Notes land on their frame in this buffer
+            if (m_MidiPort)
+            {
+                void* _midi = jack_port_get_buffer(m_MidiPort, frames);
+                jack_nframes_t _count = jack_midi_get_event_count(_midi);
+                for (jack_nframes_t i = 0; i < _count; i++)
+                {
+                    jack_midi_event_t _event;
+                    if (jack_midi_event_get(&_event, _midi, i) != 0 || _event.size < 3)
+                        continue;
+
+                    int _status = _event.buffer[0] & 0xF0;
+                    bool _press = _status == 0x90 && _event.buffer[2] > 0;
+                    bool _release = _status == 0x80 || (_status == 0x90 && _event.buffer[2] == 0);
+                    if (_press || _release)
+                        m_Engine->Send({
+                            .type = _press ? Engine::Event::Press : Engine::Event::Release,
+                            .note = _event.buffer[1],
+                            .velocity = _event.buffer[2],
+                            .frame = m_Engine->FramesRendered() + _event.time,
+                        });
+                }
+            }
+
+            // Render in parts when the server buffer grew after starting
+            for (jack_nframes_t i = 0; i < frames; i += m_Format.bufferSize)
+            {
+                jack_nframes_t _size = std::min<jack_nframes_t>(m_Format.bufferSize, frames - i);
+                m_Engine->Process({ m_Buffer.data(), _size * _channels }, _channels);
+                for (int j = 0; j < _channels; j++)
+                {
+                    auto _out = static_cast<jack_default_audio_sample_t*>(jack_port_get_buffer(m_Ports[j], frames)) + i;
+                    for (jack_nframes_t k = 0; k < _size; k++)
+                        _out[k] = m_Buffer[k * _channels + j];
+                }
+            }
+
+            return 0;
+        }
+    };
+}
+
+std::unique_ptr<Backend> MakeJackBackend(const Backend::Settings& settings)
+{
+    return std::make_unique<JackBackend>(settings);
+}
@@ -0,0 +1,89 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return m_File = nullptr, false;
+
+    LARGE_INTEGER _size;
+    if (!GetFileSizeEx(m_File, &_size))
+        return Close(), false;
+
+    m_Size = static_cast<std::size_t>(_size.QuadPart);
+    if (m_Size == 0)
+        return true;
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping)
+        return Close(), false;
+
+    m_Data = static_cast<const std::uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    return m_Data ? true : (Close(), false);
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File)
+        CloseHandle(m_File);
+
+    m_Data = nullptr, m_Mapping = nullptr, m_File = nullptr;
+    m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    int _file = open(path.c_str(), O_RDONLY);
+    if (_file < 0)
+        return false;
+
+    struct stat _stat;
+    if (fstat(_file, &_stat) != 0)
+        return close(_file), false;
+
+    m_Size = static_cast<std::size_t>(_stat.st_size);
+    if (m_Size > 0)
+    {
+        void* _data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, _file, 0);
+        if (_data == MAP_FAILED)
+            return close(_file), m_Size = 0, false;
+
+        // Read ahead, the file is read front to back
+        madvise(_data, m_Size, MADV_SEQUENTIAL);
+        m_Data = static_cast<const std::uint8_t*>(_data);
+    }
+
+    close(_file); // The mapping keeps the file open
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        munmap(const_cast<std::uint8_t*>(m_Data), m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include "MidiFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    std::uint32_t Big(const std::uint8_t* data, int bytes)
+    {
+        std::uint32_t _value = 0;
+        for (int i = 0; i < bytes; i++)
+            _value = (_value << 8) | data[i];
+        return _value;
+    }
+
+    // Variable length quantity, at most 4 bytes. False when it runs past the end.
+    bool Vlq(const std::uint8_t* data, std::size_t& position, std::size_t end, std::uint32_t& value)
+    {
+        value = 0;
+        for (int i = 0; i < 4 && position < end; i++)
+        {
+            std::uint8_t _byte = data[position++];
+            value = (value << 7) | (_byte & 0x7F);
+            if (!(_byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    // Top of the heap is the track with the earliest next event
+    bool Later(const auto& a, const auto& b)
+    {
+        return a.tick != b.tick ? a.tick > b.tick : a.index > b.index;
+    }
+}
+
+bool MidiFile::Open(const std::string& path, double sampleRate)
+{
+    m_Chunks.clear();
+    m_Tracks.clear();
+    if (!m_File.Open(path))
+        return false;
+
+    auto _data = m_File.Data();
+    if (_data.size() < 14 || !std::equal(_data.begin(), _data.begin() + 4, "MThd"))
+        return false;
+
+    std::size_t _length = Big(&_data[4], 4);
+    m_Format = Big(&_data[8], 2);
+    int _count = Big(&_data[10], 2);
+    int _division = Big(&_data[12], 2);
+    if (_length < 6 || m_Format > 1)
+        return false;
+
+    // Negative smpte frame rate in the high byte, ticks per frame in the low byte
+    m_Smpte = _division & 0x8000;
+    m_Division = m_Smpte
+        ? -static_cast<std::int8_t>(_division >> 8) * static_cast<double>(_division & 0xFF)
+        : static_cast<double>(_division);
+    if (m_Division <= 0)
+        return false;
+
+    // Only the chunk headers are read here, unknown chunks are skipped
+    std::size_t _position = 8 + _length;
+    while (static_cast<int>(m_Chunks.size()) < _count && _position + 8 <= _data.size())
+    {
+        std::size_t _size = Big(&_data[_position + 4], 4);
+        std::size_t _begin = _position + 8;
+        std::size_t _end = std::min(_begin + _size, _data.size()); // Truncated files play up to the end
+        if (std::equal(&_data[_position], &_data[_position + 4], "MTrk"))
+            m_Chunks.push_back({ _begin, _end });
+        _position = _begin + _size;
+    }
+
+    m_SampleRate = sampleRate;
+    Rewind();
+    return true;
+}
+
+void MidiFile::Rewind()
+{
+    m_Tracks.clear();
+    for (std::size_t i = 0; i < m_Chunks.size(); i++)
+    {
+        Track _track{ .position = m_Chunks[i].begin, .end = m_Chunks[i].end, .tick = 0, .index = static_cast<int>(i) };
+        if (m_Delta(_track))
+            m_Tracks.push_back(_track);
+    }
+    std::make_heap(m_Tracks.begin(), m_Tracks.end(), Later<Track, Track>);
+
+    // 120 bpm until the first tempo change
+    m_TempoTick = 0;
+    m_TempoFrame = 0;
+    m_Tempo(0, 0.5);
+}
+
+bool MidiFile::Next(Engine::Event& event)
+{
+    while (!m_Tracks.empty())
+    {
+        std::pop_heap(m_Tracks.begin(), m_Tracks.end(), Later<Track, Track>);
+        Track& _track = m_Tracks.back();
+        bool _note = m_Read(_track, event);
+
+        if (m_Delta(_track))
+            std::push_heap(m_Tracks.begin(), m_Tracks.end(), Later<Track, Track>);
+        else
+            m_Tracks.pop_back();
+
+        if (_note)
+            return true;
+    }
+    return false;
+}
+
+void MidiFile::m_Tempo(std::uint64_t tick, double secondsPerQuarter)
+{
+    m_TempoFrame += (tick - m_TempoTick) * m_FramesPerTick;
+    m_TempoTick = tick;
+
+    // Smpte time doesn't change with the tempo
+    m_FramesPerTick = m_Smpte
+        ? m_SampleRate / m_Division
+        : secondsPerQuarter * m_SampleRate / m_Division;
+}
+
+bool MidiFile::m_Delta(Track& track)
+{
+    std::uint32_t _delta = 0;
+    if (!Vlq(m_File.Data().data(), track.position, track.end, _delta))
+        return false;
+
+    track.tick += _delta;
+    return true;
+}
+
+bool MidiFile::m_Read(Track& track, Engine::Event& event)
+{
+    const std::uint8_t* _data = m_File.Data().data();
+    auto _end = [&] { track.position = track.end; return false; };
+    if (track.position >= track.end)
+        return _end();
+
+    // Data bytes without a status byte reuse the last one
+    std::uint8_t _status = _data[track.position];
+    if (_status & 0x80)
+        track.position++;
+    else if (track.status)
+        _status = track.status;
+    else
+        return _end();
+
+    // System messages, meta and sysex events included, clear the running status
+    track.status = _status < 0xF0 ? _status : 0;
+
+    if (_status == 0xFF)
+    {
+        if (track.position >= track.end)
+            return _end();
+
+        std::uint8_t _type = _data[track.position++];
+        std::uint32_t _length = 0;
+        if (!Vlq(_data, track.position, track.end, _length) || track.position + _length > track.end)
+            return _end();
+
+        if (_type == 0x51 && _length == 3)
+            m_Tempo(track.tick, Big(&_data[track.position], 3) / 1000000.);
+        else if (_type == 0x2F)
+            return _end();
+
+        track.position += _length;
+        return false;
+    }
+
+    if (_status == 0xF0 || _status == 0xF7)
+    {
+        std::uint32_t _length = 0;
+        if (!Vlq(_data, track.position, track.end, _length) || track.position + _length > track.end)
+            return _end();
+
+        track.position += _length;
+        return false;
+    }
+
+    // Other system messages have no data in files
+    if (_status >= 0xF0)
+        return false;
+
+    std::size_t _bytes = (_status & 0xF0) == 0xC0 || (_status & 0xF0) == 0xD0 ? 1 : 2;
+    if (track.position + _bytes > track.end)
+        return _end();
+
+    const std::uint8_t* _message = &_data[track.position];
+    track.position += _bytes;
+
+    int _type = _status & 0xF0;
+    if (_type != 0x80 && _type != 0x90)
+        return false;
+
+    event = {
+        .type = _type == 0x90 && _message[1] > 0 ? Engine::Event::Press : Engine::Event::Release,
+        .note = _message[0] & 0x7F,
+        .velocity = _message[1] & 0x7F,
+        .frame = std::llround(m_TempoFrame + (track.tick - m_TempoTick) * m_FramesPerTick),
+    };
+    return true;
+}
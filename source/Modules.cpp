@@ -1,5 +1,10 @@
 #include "Modules.hpp"
 
+#include <atomic>
+#include <complex>
+#include <map>
+#include <mutex>
+
 namespace Wavetables
 {
     Sample sine(double phase, double wtpos)
@@ -21,25 +26,211 @@ namespace Wavetables
     };
 }
 
+// MipmapWavetable
+
+namespace
+{
+    // In-place radix-2 fft, inverse when sign is positive
+    void FFT(std::vector<std::complex<double>>& data, int sign)
+    {
+        std::size_t _n = data.size();
+        for (std::size_t i = 1, j = 0; i < _n; i++)
+        {
+            std::size_t _bit = _n >> 1;
+            for (; j & _bit; _bit >>= 1)
+                j ^= _bit;
+            j ^= _bit;
+            if (i < j)
+                std::swap(data[i], data[j]);
+        }
+
+        for (std::size_t _len = 2; _len <= _n; _len <<= 1)
+        {
+            double _angle = sign * 2 * std::numbers::pi_v<double> / _len;
+            std::complex<double> _w{ std::cos(_angle), std::sin(_angle) };
+            for (std::size_t i = 0; i < _n; i += _len)
+            {
+                std::complex<double> _wn = 1;
+                for (std::size_t j = 0; j < _len / 2; j++)
+                {
+                    auto _u = data[i + j];
+                    auto _v = data[i + j + _len / 2] * _wn;
+                    data[i + j] = _u + _v;
+                    data[i + j + _len / 2] = _u - _v;
+                    _wn *= _w;
+                }
+            }
+        }
+    }
+}
+
+MipmapWavetable::MipmapWavetable(const Wavetable& wavetable, double wtpos)
+    : m_Tables(TABLES * (SIZE + 1))
+{
+    std::vector<std::complex<double>> _spectrum(SIZE);
+    for (int i = 0; i < SIZE; i++)
+        _spectrum[i] = wavetable(i / static_cast<double>(SIZE), wtpos);
+
+    FFT(_spectrum, -1);
+
+    std::vector<std::complex<double>> _table(SIZE);
+    for (int t = 0; t < TABLES; t++)
+    {
+        // Only keep the harmonics of this octave, and their negative frequencies
+        int _harmonics = (SIZE / 2) >> t;
+        for (int i = 0; i < SIZE; i++)
+        {
+            int _harmonic = i <= SIZE / 2 ? i : SIZE - i;
+            _table[i] = _harmonic <= _harmonics ? _spectrum[i] : 0;
+        }
+
+        FFT(_table, 1);
+
+        float* _out = &m_Tables[t * (SIZE + 1)];
+        for (int i = 0; i < SIZE; i++)
+            _out[i] = _table[i].real() / SIZE;
+        _out[SIZE] = _out[0];
+    }
+}
+
+std::shared_ptr<const MipmapWavetable> MipmapWavetable::Get(const Wavetable& wavetable, double wtpos)
+{
+    using Function = Sample(*)(double, double);
+    auto _function = wavetable.target<Function>();
+    if (!_function)
+        return std::make_shared<MipmapWavetable>(wavetable, wtpos);
+
+    static std::mutex _mutex;
+    static std::map<std::pair<Function, double>, std::shared_ptr<const MipmapWavetable>> _cache;
+    std::lock_guard _lock{ _mutex };
+    auto& _tables = _cache[{ *_function, wtpos }];
+    if (!_tables)
+        _tables = std::make_shared<MipmapWavetable>(wavetable, wtpos);
+
+    return _tables;
+}
+
+int MipmapWavetable::Select(double delta, float& blend)
+{
+    // Table n fits below nyquist as long as delta <= 2^n / SIZE, skip one table 
+    // so both tables that are blended fit, otherwise the blend would alias.
+    double _octave = std::log2(std::abs(delta) * SIZE) + 1;
+    if (_octave <= 0)
+        return blend = 0, 0;
+
+    if (_octave >= TABLES - 1)
+        return blend = 0, TABLES - 1;
+
+    int _table = static_cast<int>(_octave);
+    blend = _octave - _table;
+    return _table;
+}
+
+// CurveTable
+
+CurveTable::CurveTable(double curve)
+    : m_Curve(curve), m_Table(SIZE + 1)
+{
+    for (int i = 0; i <= SIZE; i++)
+        m_Table[i] = std::pow(i / static_cast<double>(SIZE), curve);
+}
+
+namespace
+{
+    // Tables published by Get for Find, never changed once the count includes them
+    const CurveTable* sharedCurves[CurveTable::MAX_SHARED]{};
+    std::atomic<int> sharedCurveCount = 0;
+}
+
+const CurveTable& CurveTable::Get(double curve)
+{
+    static std::mutex _mutex;
+    static std::map<double, std::unique_ptr<const CurveTable>> _cache;
+    std::lock_guard _lock{ _mutex };
+    auto& _table = _cache[curve];
+    if (!_table)
+    {
+        _table = std::make_unique<CurveTable>(curve);
+        int _count = sharedCurveCount.load(std::memory_order_relaxed);
+        if (_count < MAX_SHARED)
+        {
+            sharedCurves[_count] = _table.get();
+            sharedCurveCount.store(_count + 1, std::memory_order_release);
+        }
+    }
+
+    return *_table;
+}
+
+const CurveTable* CurveTable::Find(double curve)
+{
+    int _count = sharedCurveCount.load(std::memory_order_acquire);
+    for (int i = 0; i < _count; i++)
+        if (sharedCurves[i]->Curve() == curve)
+            return sharedCurves[i];
+    return nullptr;
+}
+
 // ADSR
 
-void ADSR::Generate(Channel)
+void ADSR::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+
+    // Calculate the tables of the current curves here, processing only finds them
+    for (double i : { settings.attackCurve, settings.decayCurve, settings.releaseCurve })
+        CurveTable::Get(i);
+    m_Segments();
+}
+
+void ADSR::m_Segments()
+{
+    // Runs on the audio thread, so it only looks up tables that were already calculated
+    double _curves[3]{ settings.attackCurve, settings.decayCurve, settings.releaseCurve };
+    for (int i = 0; i < 3; i++)
+        if (m_Curve[i] != _curves[i])
+            m_Curve[i] = _curves[i], m_Curves[i] = CurveTable::Find(_curves[i]);
+
+    m_Inverse[0] = 1 / settings.attack;
+    m_Inverse[1] = 1 / settings.decay;
+    m_Inverse[2] = 1 / settings.release;
+}
+
+void ADSR::m_Advance(int frames)
 {
-    if (m_Phase >= 0 && (m_Phase < settings.attack + settings.decay || !m_Gate))
-        m_Phase += 1.0 / (double)SAMPLE_RATE;
+    double _ad = settings.attack + settings.decay;
+    if (m_Phase >= 0 && (m_Phase < _ad || !m_Gate))
+        m_Phase += frames / m_SampleRate;
 
     else if (m_Gate)
-        m_Phase = settings.attack + settings.decay;
+        m_Phase = _ad;
 
-    if (m_Phase > settings.attack + settings.decay + settings.release) m_Phase = -1;
+    if (m_Phase > _ad + settings.release) m_Phase = -1;
 
     sample = m_Phase < 0 ? 0
-        : m_Phase < settings.attack ? std::pow(m_Phase / settings.attack, settings.attackCurve)
-        : m_Phase <= settings.attack + settings.decay ? 1 - (1 - settings.sustain) * std::pow((m_Phase - settings.attack) / settings.decay, settings.decayCurve)
-        : m_Phase < settings.attack + settings.decay + settings.release ? m_Down - m_Down * std::pow((m_Phase - settings.attack - settings.decay) / settings.release, settings.releaseCurve)
+        : m_Phase < settings.attack ? m_Shape(0, m_Phase * m_Inverse[0])
+        : m_Phase <= _ad ? 1 - (1 - settings.sustain) * m_Shape(1, (m_Phase - settings.attack) * m_Inverse[1])
+        : m_Phase < _ad + settings.release ? m_Down - m_Down * m_Shape(2, (m_Phase - _ad) * m_Inverse[2])
         : 0;
 }
 
+void ADSR::Advance(int frames)
+{
+    m_Segments();
+    m_Advance(frames);
+}
+
+void ADSR::ProcessBlock(std::span<Sample> block, int channels)
+{
+    m_Segments();
+    for (std::size_t i = 0; i < block.size(); i += channels)
+    {
+        m_Advance(1);
+        for (int c = 0; c < channels; c++)
+            block[i + c] *= sample;
+    }
+}
+
 void ADSR::Trigger()
 {
     m_Down = settings.sustain;
@@ -68,30 +259,79 @@ void ADSR::Gate(bool g)
 
 // Oscillator
 
-void Oscillator::Generate(Channel c)
+void Oscillator::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+
+    // Also without band-limiting, so it can be turned on while processing
+    m_Frequency = 0;
+    m_Tables = MipmapWavetable::Get(settings.wavetable, settings.wtpos);
+}
+
+void Oscillator::Generate()
 {
-    if (c != 0)
+    // Building the tables locks and allocates, so until they are prepared 
+    // the oscillator oversamples
+    if (settings.bandlimited && m_Tables)
+    {
+        double delta = settings.frequency / m_SampleRate;
+        if (settings.frequency != m_Frequency)
+            m_Frequency = settings.frequency, m_Table = MipmapWavetable::Select(delta, m_Blend);
+
+        sample = m_Tables->Lookup(m_Phase, m_Table, m_Blend);
+        m_Phase += delta;
+        m_Phase -= std::floor(m_Phase);
         return;
-    Sample _avg = 0;
-    m_Params.sampleRate = SAMPLE_RATE * settings.oversample;
-    m_Params.f0 = SAMPLE_RATE * 0.4;
-    m_Params.Q = 1;
-    m_Params.type = FilterType::LowPass;
-    m_Params.RecalculateParameters();
+    }
+
+    // The filter only changes with the sample rate or oversampling
+    if (m_Rate.Changed(m_SampleRate, settings.oversample))
+    {
+        m_Params.sampleRate = m_SampleRate * settings.oversample;
+        m_Params.f0 = m_SampleRate * 0.4;
+        m_Params.Q = 1;
+        m_Params.type = FilterType::LowPass;
+        m_Params.RecalculateParameters();
+        m_Filter.Set(m_Params);
+    }
 
+    Sample _avg = 0;
     for (int i = 0; i < settings.oversample; i++)
     {
         float _s = settings.wavetable(m_Phase, settings.wtpos);
-        for (auto& i : m_Filter)
-            _s = i.Apply(_s, m_Params);
-        _avg += _s;
-        double delta = settings.frequency / (SAMPLE_RATE * settings.oversample);
+        _avg += m_Filter.Process(_s, 0);
+        double delta = settings.frequency / (m_SampleRate * settings.oversample);
         m_Phase = std::fmod(1 + m_Phase + delta, 1);
     }
 
     sample = _avg /= settings.oversample;
 }
 
+void Oscillator::Advance(int frames)
+{
+    // Only read by modulation, so no need for band-limiting
+    double delta = settings.frequency / m_SampleRate;
+    sample = settings.wavetable(m_Phase, settings.wtpos);
+    m_Phase += delta * frames;
+    m_Phase -= std::floor(m_Phase);
+}
+
+void Oscillator::ProcessBlock(std::span<Sample> block, int channels)
+{
+    for (std::size_t i = 0; i < block.size(); i += channels)
+    {
+        Oscillator::Generate();
+        for (int c = 0; c < channels; c++)
+            block[i + c] += sample;
+    }
+}
+
+void Oscillator::UpdateTables()
+{
+    m_Frequency = 0;
+    m_Tables = settings.bandlimited ? MipmapWavetable::Get(settings.wavetable, settings.wtpos) : nullptr;
+}
+
 Sample Oscillator::Offset(double phaseoffset)
 {
     return settings.wavetable(std::fmod(1 + m_Phase + phaseoffset, 1), settings.wtpos);
@@ -104,127 +344,252 @@ Sample Oscillator::Apply(Sample s, Channel)
 
 // Chorus
 
-void Chorus::Channels(int c)
+void Chorus::Prepare(double sampleRate, int maxBlockSize, int channels)
 {
-    m_Buffers.reserve(c);
-    while (m_Buffers.size() < c)
-    {
-        auto& a = m_Buffers.emplace_back();
-        while (a.size() < BUFFER_SIZE)
-            a.emplace_back(0);
-    }
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+    settings.oscillator.Prepare(sampleRate, maxBlockSize, channels);
+    m_Line.Prepare(BUFFER_SIZE - 4, channels);
 }
 
-Sample Chorus::Apply(Sample sin, Channel c)
+void Chorus::Generate()
 {
-    Channels(c + 1);
-
-    if (c == 0)
-    {
-        m_Position = (m_Position + 1) % BUFFER_SIZE;
-        settings.oscillator.Generate(c);
-    }
+    m_Line.Advance();
+    settings.oscillator.Advance(1); // Lfo, doesn't need oversampling
+}
 
-    m_Delay1t = ((settings.delay1 + settings.oscillator.Offset(settings.stereo ? (c % 2) * 0.5 : 0) * settings.amount) / 1000.0) * SAMPLE_RATE;
-    m_Delay2t = ((settings.delay2 + settings.oscillator.Offset(settings.stereo ? (c % 2) * 0.5 : 0) * settings.amount) / 1000.0) * SAMPLE_RATE;
+Sample Chorus::Apply(Sample sin, Channel c)
+{
+    return m_Apply(sin, c, settings.mix);
+}
 
-    m_Delay1t = (std::max(m_Delay1t, 1)) % BUFFER_SIZE;
-    m_Delay2t = (std::max(m_Delay2t, 1)) % BUFFER_SIZE;
+Sample Chorus::m_Apply(Sample sin, Channel c, Sample mix)
+{
+    // Not prepared for this channel
+    if (c >= m_Line.Channels())
+        return sin;
 
-    auto& _buffer = m_Buffers[c];
+    // Fractional delays, so the modulation doesn't step
+    double _lfo = settings.oscillator.Offset(settings.stereo ? (c % 2) * 0.5 : 0) * settings.amount;
+    double _max = m_Line.MaxDelay();
+    double _delay1 = std::clamp((settings.delay1 + _lfo) / 1000.0 * m_SampleRate, 1.0, _max);
+    double _delay2 = std::clamp((settings.delay2 + _lfo) / 1000.0 * m_SampleRate, 1.0, _max);
 
+    float now = m_Line.Read(c, _delay1);
     if (settings.enableDelay2)
-    {
-        int i1 = (m_Position - m_Delay1t + BUFFER_SIZE) % BUFFER_SIZE;
-        int i2 = (m_Position - m_Delay2t + BUFFER_SIZE) % BUFFER_SIZE;
+        now = (now + m_Line.Read(c, _delay2)) / 2.0;
 
-        float del1s = _buffer[i1];
-        float del2s = _buffer[i2];
+    m_Line.Write(c, sin + settings.polarity * now * settings.feedback);
 
-        float now = (del1s + del2s) / 2.0;
-
-        _buffer[m_Position] = sin + settings.polarity * now * settings.feedback;
+    return sin * (1.0 - mix) + now * mix;
+};
 
-        return sin * (1.0 - settings.mix) + now * settings.mix;
-    }
-    else
+void Chorus::ProcessBlock(std::span<Sample> block, int channels)
+{
+    // The mix is set once per block by Mod, ramp from the mix of the last block
+    m_Mix.Target(settings.mix, block.size() / channels);
+    for (std::size_t i = 0; i < block.size(); i += channels)
     {
-        int i1 = (m_Position - m_Delay1t + BUFFER_SIZE) % BUFFER_SIZE;
-
-        float del1s = _buffer[i1];
-
-        float now = del1s;
-
-        _buffer[m_Position] = sin + settings.polarity * now * settings.feedback;
-
-        return sin * (1.0 - settings.mix) + now * settings.mix;
+        Chorus::Generate();
+        Sample _mix = m_Mix.Next();
+        for (int c = 0; c < channels; c++)
+            block[i + c] = m_Apply(block[i + c], c, _mix);
     }
-};
+}
 
 // LPF
 
-void LPF::Generate(Channel) 
+void LPF::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+    m_Filter.Prepare(channels);
+    m_Interpolate = false;
+}
+
+void LPF::Generate() 
 {
-    m_Params.sampleRate = SAMPLE_RATE;
+    if (!m_Settings.Changed(m_SampleRate, settings.frequency, settings.resonance, settings.mix))
+        return;
+
+    m_Params.sampleRate = m_SampleRate;
     m_Params.type = FilterType::LowPass;
     m_Params.f0 = settings.frequency;
     m_Params.Q = settings.resonance;
     m_Params.RecalculateParameters();
+    m_Filter.coefficients[0] = m_Mixed();
 }
 
 Sample LPF::Apply(Sample s, Channel c) 
 {
-    return m_Filter.Apply(s, c) * settings.mix + s * (1 - settings.mix);
+    return c < m_Filter.Channels() ? m_Filter.Process(s, c) : s;
 }
 
-// Delay
-
-void Delay::Channels(int c)
+void LPF::ProcessBlock(std::span<Sample> block, int channels)
 {
-    BUFFER_SIZE = SAMPLE_RATE * 10;
-    m_Equalizers.reserve(c);
-    while (m_Equalizers.size() < c)
-        m_Equalizers.emplace_back(m_Parameters.Parameters());
+    if (block.empty())
+        return;
+
+    if (channels != m_Filter.Channels())
+        return Module::ProcessBlock(block, channels);
+
+    // Calculate the coefficients once per block, and interpolate from the 
+    // coefficients of the last block so modulation doesn't step.
+    LPF::Generate();
+    Filter::Coefficients _end = m_Filter.coefficients[0];
+    if (!m_Interpolate)
+        m_Coefficients = _end;
+
+    constexpr double Filter::Coefficients::* _members[5]{ &Filter::Coefficients::b0, 
+        &Filter::Coefficients::b1, &Filter::Coefficients::b2, &Filter::Coefficients::a1, &Filter::Coefficients::a2 };
 
-    m_Buffers.reserve(c);
-    while (m_Buffers.size() < c)
+    double _step[5];
+    std::size_t _frames = block.size() / channels;
+    for (int i = 0; i < 5; i++)
+        _step[i] = (_end.*_members[i] - m_Coefficients.*_members[i]) / _frames;
+
+    for (std::size_t i = 0; i < block.size(); i += channels)
     {
-        auto& a = m_Buffers.emplace_back();
-        while (a.size() < BUFFER_SIZE)
-            a.emplace_back(0);
+        for (int j = 0; j < 5; j++)
+            m_Coefficients.*_members[j] += _step[j];
+
+        m_Filter.coefficients[0] = m_Coefficients;
+        m_Filter.Process(block.data() + i);
     }
+
+    m_Filter.coefficients[0] = m_Coefficients = _end;
+    m_Interpolate = true;
+}
+
+LPF::Filter::Coefficients LPF::m_Mixed() const
+{
+    // mix * H + (1 - mix), both over the same denominator
+    double _mix = settings.mix, _dry = 1 - settings.mix;
+    return {
+        .b0 = _mix * m_Params.b0a0 + _dry,
+        .b1 = _mix * m_Params.b1a0 + _dry * m_Params.a1a0,
+        .b2 = _mix * m_Params.b2a0 + _dry * m_Params.a2a0,
+        .a1 = m_Params.a1a0,
+        .a2 = m_Params.a2a0,
+    };
 }
 
-void Delay::Generate(Channel c)
+// Delay
+
+void Delay::Prepare(double sampleRate, int maxBlockSize, int channels)
 {
-    Channels(c + 1);
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+    m_Oscillator.Prepare(sampleRate, maxBlockSize, channels);
+    m_Line.Prepare(sampleRate * 10, channels);
+    m_Block.assign(static_cast<std::size_t>(maxBlockSize + 1) * channels, 0);
+
+    m_Filter.Prepare(channels);
+}
+
+void Delay::Generate()
+{
+    m_Update();
+    m_Oscillator.settings.frequency = settings.mod.rate;
+    m_Line.Advance();
+    m_Oscillator.Advance(1);
+}
+
+void Delay::m_Update()
+{
+    if (m_Gains.Changed(settings.gain))
+        m_Gain = db2lin(settings.gain);
+
+    if (!m_Filters.Changed(m_SampleRate, m_Parameters.freq, m_Parameters.width))
+        return;
+
     m_Parameters.RecalculateParameters();
+    m_Filter.Set(m_Parameters.Parameters()[0], 0);
+    m_Filter.Set(m_Parameters.Parameters()[1], 1);
 }
 
 Sample Delay::Apply(Sample sin, Channel c)
 {
-    float in = sin * db2lin(settings.gain);
-    if (c == 0)
-    {
-        m_Oscillator.settings.frequency = settings.mod.rate;
-        m_Position = (m_Position + 1) % BUFFER_SIZE;
-        m_Oscillator.Generate(c);
-    }
+    return m_Apply(sin, c, settings.mix);
+}
+
+Sample Delay::m_Apply(Sample sin, Channel c, Sample mix)
+{
+    // Not prepared for this channel
+    if (c >= m_Line.Channels())
+        return sin;
+
+    float in = sin * m_Gain;
+
+    double _delay = ((settings.delay + settings.delay * m_Oscillator * settings.mod.amount * 0.01 * 0.9) / 1000.0) * m_SampleRate;
+    _delay = std::clamp(_delay, 1.0, m_Line.MaxDelay() / 1.5);
+
+    // In stereo the odd channels are delayed by half the time more, and their 
+    // feedback is written that much earlier so the repeats stay the same time apart.
+    double _offset = settings.stereo ? (c % 2) * _delay * 0.5 : 0;
+    float del1s = m_Line.Read(c, _delay + _offset);
+
+    float now = settings.filter ? m_Filter.Process(del1s, c) : del1s;
 
-    int s = settings.stereo ? ((c % 2) * 0.5) : 0;
-    int delayt = ((settings.delay + settings.delay * m_Oscillator * settings.mod.amount * 0.01 * 0.9) / 1000.0) * SAMPLE_RATE;
-    delayt = (std::max(delayt, 1)) % BUFFER_SIZE;
+    if (settings.stereo)
+        m_Line.Write(c, in), m_Line.Add(c, now * settings.feedback, static_cast<std::size_t>(_offset) + 1);
+    else
+        m_Line.Write(c, in + now * settings.feedback);
 
-    auto& _buffer = m_Buffers[c];
-    int i1 = (int)(m_Position - (settings.stereo ? (delayt + delayt * (c % 2) * 0.5) : delayt) + 3 * BUFFER_SIZE) % BUFFER_SIZE;
+    return sin * (1.0 - mix) + now * mix;
+}
 
-    float del1s = _buffer[i1];
+void Delay::ProcessBlock(std::span<Sample> block, int channels)
+{
+    // Without modulation or stereo offsets the delay is fixed for the whole block, 
+    // so when it's longer than the block all delayed frames can be read at once.
+    double _delay = std::max(settings.delay / 1000.0 * m_SampleRate, 1.0);
+    std::size_t _frames = block.size() / channels;
+    std::size_t _whole = static_cast<std::size_t>(_delay);
+
+    // The mix is set once per block by Mod, ramp from the mix of the last block
+    m_Mix.Target(settings.mix, _frames);
+    if (settings.mod.amount != 0 || settings.stereo || channels != m_Line.Channels() || channels != m_Filter.Channels()
+        || block.size() + channels > m_Block.size() || _whole < _frames || _delay > m_Line.MaxDelay() / 1.5)
+    {
+        for (std::size_t i = 0; i < block.size(); i += channels)
+        {
+            Delay::Generate();
+            Sample _mix = m_Mix.Next();
+            for (int c = 0; c < channels; c++)
+                block[i + c] = m_Apply(block[i + c], c, _mix);
+        }
+        return;
+    }
+
+    m_Oscillator.settings.frequency = settings.mod.rate;
+    m_Oscillator.Advance(_frames);
+    m_Update();
 
-    float now = settings.filter ? m_Equalizers[c].Apply(del1s) : del1s;
+    // One frame more than the block, frame i + 1 is delayed by the whole frames and 
+    // frame i by one more, same interpolation as the per sample path.
+    std::span<float> _delayed{ m_Block.data(), block.size() + channels };
+    m_Line.Read(_delayed, _whole + 1);
 
-    int next = settings.stereo ? ((int)(m_Position - (c % 2) * delayt * 0.5 - 1 + 3 * BUFFER_SIZE) % BUFFER_SIZE) : m_Position;
-    _buffer[m_Position] = in;
-    _buffer[next] += now * settings.feedback;
+    float _frac = _delay - _whole;
+    float _gain = m_Gain;
+    for (std::size_t i = 0; i < block.size(); i += channels)
+    {
+        Sample _mix = m_Mix.Next();
+
+        // Frame i is no longer read, so the delayed frame can be written in its place
+        float* _now = &_delayed[i];
+        for (int c = 0; c < channels; c++)
+            _now[c] = _now[c + channels] + (_now[c] - _now[c + channels]) * _frac;
+
+        if (settings.filter)
+            m_Filter.Process(_now);
+
+        // And then the input
+        for (int c = 0; c < channels; c++)
+        {
+            float now = _now[c];
+            _now[c] = static_cast<float>(block[i + c] * _gain) + now * settings.feedback;
+            block[i + c] = block[i + c] * (1.0 - _mix) + now * _mix;
+        }
+    }
 
-    return sin * (1.0 - settings.mix) + now * settings.mix;
+    m_Line.Write(_delayed.first(block.size()));
 }
@@ -0,0 +1,164 @@
+#include "Monitor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define SYNTHMAKR_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SYNTHMAKR_RDTSC
+#endif
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+namespace
+{
+    std::int64_t Nanoseconds()
+    {
+        auto _now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(_now).count();
+    }
+}
+
+std::array<Monitor::Counter, Monitor::MAX_MODULES> Monitor::m_Counters{};
+
+std::uint64_t Monitor::Ticks()
+{
+#ifdef SYNTHMAKR_RDTSC
+    return __rdtsc();
+#else
+    return Nanoseconds();
+#endif
+}
+
+int Monitor::m_Register(const char* type)
+{
+    int _slot = m_Modules.fetch_add(1, std::memory_order_relaxed);
+    if (_slot >= MAX_MODULES)
+        return -1;
+
+    m_Counters[_slot].type.store(type, std::memory_order_release);
+    return _slot;
+}
+
+void Monitor::m_Add(int slot, std::uint64_t ticks)
+{
+    if (slot < 0)
+        return;
+
+    // Voices rendered on a pool add from several threads
+    m_Counters[slot].calls.fetch_add(1, std::memory_order_relaxed);
+    m_Counters[slot].ticks.fetch_add(ticks, std::memory_order_relaxed);
+}
+
+void Monitor::m_Begin(std::int64_t frames, double sampleRate)
+{
+    std::int64_t _now = Nanoseconds();
+    if (m_Start && _now - m_Start > m_Period * 1.5e9)
+        m_Stats.xruns++;
+
+    m_Start = _now;
+    m_StartTicks = Ticks();
+    m_Period = frames / sampleRate;
+}
+
+void Monitor::m_End(int voices)
+{
+    std::int64_t _now = Nanoseconds();
+    std::uint64_t _ticks = Ticks();
+    double _seconds = (_now - m_Start) * 1e-9;
+    m_Nanoseconds += _now - m_Start;
+    m_Ticks += _ticks - m_StartTicks;
+
+    Stats& _stats = m_Stats;
+    double _load = m_Period > 0 ? _seconds / m_Period * 100 : 0;
+    _stats.blocks++;
+    _stats.load = _load;
+    _stats.peak = std::max(_stats.peak, _load);
+    _stats.longest = std::max(_stats.longest, _seconds);
+    _stats.overruns += _load > 100;
+    _stats.voices = voices;
+    _stats.histogram[std::min(static_cast<int>(_load / 10), BUCKETS - 1)]++;
+
+    // Smooth over about a second of blocks
+    double _weight = std::min(m_Period, 1.);
+    _stats.average = _stats.blocks == 1 ? _load : _stats.average + (_load - _stats.average) * _weight;
+
+    double _secondsPerTick = m_Ticks ? m_Nanoseconds * 1e-9 / m_Ticks : 0;
+    _stats.modules = std::min(m_Modules.load(std::memory_order_relaxed), MAX_MODULES);
+    for (int i = 0; i < _stats.modules; i++)
+    {
+        _stats.module[i].type = m_Counters[i].type.load(std::memory_order_acquire);
+        _stats.module[i].calls = m_Counters[i].calls.load(std::memory_order_relaxed);
+        _stats.module[i].seconds = m_Counters[i].ticks.load(std::memory_order_relaxed) * _secondsPerTick;
+    }
+
+    // Publish, the reader swaps the middle buffer with its own
+    m_Buffers[m_Back] = _stats;
+    m_Back = m_Middle.exchange(m_Back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+Monitor::Stats Monitor::Read()
+{
+    if (m_Middle.load(std::memory_order_relaxed) & FRESH)
+        m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & ~FRESH;
+    return m_Buffers[m_Front];
+}
+
+std::string Monitor::Name(const char* type)
+{
+    if (!type)
+        return "";
+
+#if __has_include(<cxxabi.h>)
+    int _status = 0;
+    std::unique_ptr<char, void(*)(void*)> _demangled{ abi::__cxa_demangle(type, nullptr, nullptr, &_status), std::free };
+    if (_status == 0)
+        return _demangled.get();
+#endif
+
+    // Msvc names are readable, without the class keyword
+    std::string _name = type;
+    for (const char* prefix : { "struct ", "class " })
+        if (_name.starts_with(prefix))
+            return _name.substr(std::char_traits<char>::length(prefix));
+    return _name;
+}
+
+std::string Monitor::Json(const Stats& stats)
+{
+    std::ostringstream _out;
+    _out << "{\n"
+        << "  \"blocks\": " << stats.blocks << ",\n"
+        << "  \"load\": " << stats.load << ",\n"
+        << "  \"average\": " << stats.average << ",\n"
+        << "  \"peak\": " << stats.peak << ",\n"
+        << "  \"longest\": " << stats.longest << ",\n"
+        << "  \"overruns\": " << stats.overruns << ",\n"
+        << "  \"xruns\": " << stats.xruns << ",\n"
+        << "  \"voices\": " << stats.voices << ",\n"
+        << "  \"histogram\": [";
+
+    for (int i = 0; i < BUCKETS; i++)
+        _out << (i ? ", " : " ") << stats.histogram[i];
+
+    _out << " ],\n"
+        << "  \"modules\": [\n";
+
+    for (int i = 0; i < stats.modules; i++)
+    {
+        auto& _module = stats.module[i];
+        _out << "    { \"type\": \"" << Name(_module.type) << "\", \"calls\": " << _module.calls
+            << ", \"seconds\": " << _module.seconds << " }" << (i + 1 < stats.modules ? "," : "") << "\n";
+    }
+
+    _out << "  ]\n}\n";
+    return _out.str();
+}
@@ -0,0 +1,82 @@
+#include "Backends.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    // Paces the callbacks with the clock like a device would, and drops the output.
+    // A callback that ends after the queued buffers ran out is an xrun, after which
+    // the pacing restarts.
+    class NullBackend : public Backend
+    {
+    public:
+        using Backend::Backend;
+        ~NullBackend() override { Stop(); }
+
+        std::vector<Device> Devices() override { return { { "", "Null" } }; }
+
+        bool Start(Engine& engine) override
+        {
+            Stop();
+            m_Format = settings;
+            m_Format.bufferSize = settings.bufferSize > 0 ? settings.bufferSize : DEFAULT_BUFFER_SIZE;
+            m_Format.periods = std::max(settings.periods, 2);
+            m_Format.channels = std::max(settings.channels, 1);
+
+            engine.Prepare(m_Format.sampleRate, m_Format.bufferSize, m_Format.channels);
+            m_Buffer.assign(static_cast<std::size_t>(m_Format.bufferSize) * m_Format.channels, 0);
+            m_Xruns = 0;
+            m_Running = true;
+            m_Thread = std::thread{ [this, &engine] { m_Run(engine); } };
+            return true;
+        }
+
+        void Stop() override
+        {
+            m_Running = false;
+            if (m_Thread.joinable())
+                m_Thread.join();
+        }
+
+    private:
+        std::vector<Sample> m_Buffer;
+        std::atomic<bool> m_Running = false;
+        std::thread m_Thread;
+
+        void m_Run(Engine& engine)
+        {
+            using Clock = std::chrono::steady_clock;
+            RealtimePriority();
+            Trace::Name("Null");
+
+            auto _period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>{ m_Format.bufferSize / m_Format.sampleRate });
+            auto _start = Clock::now();
+            std::int64_t _callbacks = 0;
+            while (m_Running.load(std::memory_order_relaxed))
+            {
+                engine.Process(m_Buffer, m_Format.channels);
+
+                // The device still had the other queued buffers when the callback started
+                auto _deadline = _start + _period * (_callbacks + m_Format.periods - 1);
+                auto _now = Clock::now();
+                if (_now > _deadline)
+                {
+                    m_Xruns++;
+                    _start = _now;
+                    _callbacks = 0;
+                    continue;
+                }
+
+                std::this_thread::sleep_until(_start + _period * ++_callbacks);
+            }
+        }
+    };
+}
+
+std::unique_ptr<Backend> MakeNullBackend(const Backend::Settings& settings)
+{
+    return std::make_unique<NullBackend>(settings);
+}
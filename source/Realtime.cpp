@@ -0,0 +1,193 @@
+#include "Realtime.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+#define SYNTHMAKR_RTSAN_GLIBC
+#endif
+
+thread_local int Realtime::m_Depth = 0;
+
+namespace
+{
+    struct Report
+    {
+        Realtime::Kind kind = Realtime::Allocation;
+        int frames = 0;
+        void* stack[32]{};
+    };
+
+    std::atomic<int> violations = 0;
+    std::atomic<Realtime::Action> action = Realtime::Record;
+    Report reports[Realtime::MAX_REPORTS];
+
+    const char* Name(Realtime::Kind kind)
+    {
+        switch (kind)
+        {
+        case Realtime::Allocation: return "allocation";
+        case Realtime::Free: return "free";
+        default: return "lock";
+        }
+    }
+
+    void Print(const Report& report)
+    {
+        std::fprintf(stderr, "real-time violation: %s\n", Name(report.kind));
+        std::fflush(stderr);
+#ifdef SYNTHMAKR_RTSAN_GLIBC
+        backtrace_symbols_fd(report.stack, report.frames, STDERR_FILENO);
+#endif
+    }
+}
+
+// Called from the interposed functions, which can't be members
+struct RealtimeHooks
+{
+    static bool Checked() { return Realtime::m_Depth > 0; }
+
+    static void Violation(Realtime::Kind kind)
+    {
+        // Allocations while reporting go through unchecked
+        Realtime::m_Depth -= 1000000;
+
+        int _index = violations.fetch_add(1, std::memory_order_relaxed);
+        Report _report{ .kind = kind, .frames = 0 };
+#ifdef SYNTHMAKR_RTSAN_GLIBC
+        _report.frames = backtrace(_report.stack, 32);
+#endif
+        if (_index < Realtime::MAX_REPORTS)
+            reports[_index] = _report;
+
+        if (action.load(std::memory_order_relaxed) == Realtime::Abort)
+        {
+            Print(_report);
+            std::abort();
+        }
+
+        Realtime::m_Depth += 1000000;
+    }
+};
+
+void Realtime::OnViolation(Action a)
+{
+    action.store(a, std::memory_order_relaxed);
+}
+
+int Realtime::Violations()
+{
+    return violations.load(std::memory_order_relaxed);
+}
+
+void Realtime::Report()
+{
+    int _count = std::min(Violations(), MAX_REPORTS);
+    for (int i = 0; i < _count; i++)
+        Print(reports[i]);
+
+    if (Violations() > _count)
+        std::fprintf(stderr, "%d more real-time violations\n", Violations() - _count);
+}
+
+#ifdef SYNTHMAKR_RTSAN
+#ifdef SYNTHMAKR_RTSAN_GLIBC
+
+namespace
+{
+    // The first backtrace loads libgcc, do that before anything is checked
+    const int warm = [] { void* _stack[1]; return backtrace(_stack, 1); }();
+}
+
+// Interpose the allocator and mutexes of glibc, everything else calls these
+extern "C"
+{
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void __libc_free(void*);
+
+    void* malloc(std::size_t size)
+    {
+        if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size)
+    {
+        if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, std::size_t size)
+    {
+        if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Allocation);
+        return __libc_realloc(pointer, size);
+    }
+
+    void* aligned_alloc(std::size_t align, std::size_t size)
+    {
+        if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Allocation);
+        return __libc_memalign(align, size);
+    }
+
+    int posix_memalign(void** pointer, std::size_t align, std::size_t size)
+    {
+        if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Allocation);
+        *pointer = __libc_memalign(align, size);
+        return *pointer ? 0 : ENOMEM;
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer && RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Free);
+        __libc_free(pointer);
+    }
+
+    // Linked with --wrap, so this sees the locks of code linked with the engine,
+    // like std::mutex, but not the locks inside shared libraries.
+    int __real_pthread_mutex_lock(pthread_mutex_t*);
+    int __wrap_pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Lock);
+        return __real_pthread_mutex_lock(mutex);
+    }
+}
+
+#else
+
+// Without glibc only operator new and delete can be replaced portably
+void* operator new(std::size_t size)
+{
+    if (RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Allocation);
+    if (void* _pointer = std::malloc(size ? size : 1))
+        return _pointer;
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer && RealtimeHooks::Checked()) RealtimeHooks::Violation(Realtime::Free);
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+#endif
+#endif
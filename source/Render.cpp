@@ -0,0 +1,192 @@
+#include "Render.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+std::vector<Sample> Renderer::Render(Engine& engine, std::span<const NoteEvent> events)
+{
+    double _end = 0;
+    for (auto& i : events)
+        _end = std::max(_end, i.time);
+
+    std::vector<Sample> _out;
+    _out.reserve(static_cast<std::size_t>((_end + settings.tail) * settings.sampleRate + 1) * settings.channels);
+    Render(engine, Events({ events.begin(), events.end() }), [&](std::span<const Sample> block) {
+        _out.insert(_out.end(), block.begin(), block.end());
+    });
+
+    return _out;
+}
+
+Renderer::Source Renderer::Events(std::vector<NoteEvent> events) const
+{
+    std::stable_sort(events.begin(), events.end(), [](auto& a, auto& b) { return a.time < b.time; });
+    return [events = std::move(events), index = std::size_t{ 0 }, rate = settings.sampleRate](Engine::Event& e) mutable {
+        if (index == events.size())
+            return false;
+
+        auto& _event = events[index++];
+        e = {
+            .type = _event.press ? Engine::Event::Press : Engine::Event::Release,
+            .note = _event.note,
+            .velocity = _event.velocity,
+            .frame = static_cast<std::int64_t>(std::ceil(_event.time * rate)),
+        };
+        return true;
+    };
+}
+
+std::int64_t Renderer::Render(Engine& engine, const Source& next, const Sink& out)
+{
+    engine.Prepare(settings.sampleRate, settings.blockSize, settings.channels);
+    std::vector<Sample> _block(static_cast<std::size_t>(settings.blockSize) * settings.channels);
+
+    // The end moves with every event until the source runs out
+    std::int64_t _tail = settings.tail * settings.sampleRate;
+    std::int64_t _start = engine.FramesRendered();
+    std::int64_t _frame = 0, _end = _tail;
+
+    // Events are sent ahead of the blocks, the engine splits the blocks at their frames
+    Engine::Event _event;
+    bool _more = next(_event);
+    while (_more || _frame < _end)
+    {
+        std::int64_t _next = _frame + settings.blockSize;
+        for (; _more && _event.frame < _next; _more = next(_event))
+        {
+            _event.frame = std::max(_event.frame, _frame);
+            Engine::Event _send = _event;
+            _send.frame += _start;
+
+            // Queue is full, render up to this event first
+            if (!engine.Send(_send))
+            {
+                _next = std::max(_event.frame, _frame + 1);
+                break;
+            }
+
+            _end = std::max(_end, _event.frame + _tail);
+        }
+
+        if (!_more)
+            _next = std::min(_next, _end);
+        if (_next <= _frame)
+            break;
+
+        std::span<Sample> _out{ _block.data(), static_cast<std::size_t>(_next - _frame) * settings.channels };
+        engine.Process(_out, settings.channels);
+        out(_out);
+        _frame = _next;
+    }
+
+    return _frame;
+}
+
+std::vector<NoteEvent> DefaultEvents()
+{
+    std::vector<NoteEvent> _events;
+    int _chords[4][3]{ { 60, 64, 67 }, { 57, 60, 64 }, { 53, 57, 60 }, { 55, 59, 62 } };
+    for (int i = 0; i < 4; i++)
+        for (int note : _chords[i])
+            _events.push_back({ .time = i * 2.0, .note = note, .press = true }),
+            _events.push_back({ .time = i * 2.0 + 1.5, .note = note, .press = false });
+    return _events;
+}
+
+std::vector<NoteEvent> ParseEvents(std::istream& in)
+{
+    std::vector<NoteEvent> _events;
+    std::string _line;
+    while (std::getline(in, _line))
+    {
+        if (_line.empty() || _line[0] == '#')
+            continue;
+
+        std::istringstream _stream{ _line };
+        double _time = 0, _duration = 0;
+        int _note = 0, _velocity = 0;
+        if (!(_stream >> _time >> _note >> _velocity >> _duration))
+            continue;
+
+        _events.push_back({ .time = _time, .note = _note, .velocity = _velocity, .press = true });
+        _events.push_back({ .time = _time + _duration, .note = _note, .velocity = _velocity, .press = false });
+    }
+    return _events;
+}
+
+namespace
+{
+    // Wav files are little endian
+    template<class Ty>
+    void Little(std::ostream& out, Ty value)
+    {
+        for (std::size_t i = 0; i < sizeof(Ty); i++)
+            out.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+bool WriteWav(const std::string& path, std::span<const Sample> samples, int channels, double sampleRate)
+{
+    WavWriter _wav;
+    return _wav.Open(path, channels, sampleRate) && _wav.Write(samples) && _wav.Close();
+}
+
+bool WavWriter::Open(const std::string& path, int channels, double sampleRate)
+{
+    m_File = std::ofstream{ path, std::ios::binary };
+    m_Samples = 0;
+    if (!m_File)
+        return false;
+
+    std::uint32_t _rate = sampleRate;
+
+    // Sizes are written on Close
+    m_File.write("RIFF", 4);
+    Little<std::uint32_t>(m_File, 0);
+    m_File.write("WAVE", 4);
+
+    m_File.write("fmt ", 4);
+    Little<std::uint32_t>(m_File, 16);
+    Little<std::uint16_t>(m_File, 3); // IEEE float
+    Little<std::uint16_t>(m_File, channels);
+    Little<std::uint32_t>(m_File, _rate);
+    Little<std::uint32_t>(m_File, _rate * channels * sizeof(float));
+    Little<std::uint16_t>(m_File, channels * sizeof(float));
+    Little<std::uint16_t>(m_File, 32);
+
+    m_File.write("data", 4);
+    Little<std::uint32_t>(m_File, 0);
+    return static_cast<bool>(m_File);
+}
+
+bool WavWriter::Write(std::span<const Sample> samples)
+{
+    // Little endian bytes, written at once
+    m_Bytes.resize(samples.size() * sizeof(float));
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        std::uint32_t _bits = std::bit_cast<std::uint32_t>(static_cast<float>(samples[i]));
+        for (std::size_t j = 0; j < sizeof(float); j++)
+            m_Bytes[i * sizeof(float) + j] = static_cast<char>((_bits >> (j * 8)) & 0xFF);
+    }
+
+    m_File.write(m_Bytes.data(), m_Bytes.size());
+    m_Samples += samples.size();
+    return static_cast<bool>(m_File);
+}
+
+bool WavWriter::Close()
+{
+    // Wav sizes are 32-bit, longer files are only readable by tools that ignore them
+    std::uint32_t _size = std::min<std::uint64_t>(m_Samples * sizeof(float), 0xFFFFFFFF - 36);
+    m_File.seekp(4);
+    Little<std::uint32_t>(m_File, 36 + _size);
+    m_File.seekp(40);
+    Little<std::uint32_t>(m_File, _size);
+    m_File.close();
+    return static_cast<bool>(m_File);
+}
@@ -0,0 +1,53 @@
+#include "Simd.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace Simd
+{
+    namespace
+    {
+        int Detect()
+        {
+#if !defined(SYNTHMAKR_SIMD_X86)
+            return 4;
+#elif defined(_MSC_VER) && !defined(__clang__)
+            int _info[4];
+            __cpuid(_info, 0);
+            if (_info[0] < 7)
+                return 4;
+
+            // The os has to save the ymm and zmm registers as well
+            __cpuid(_info, 1);
+            bool _fma = _info[2] & (1 << 12), _osxsave = _info[2] & (1 << 27);
+            if (!_osxsave)
+                return 4;
+
+            unsigned long long _xcr0 = _xgetbv(0);
+            __cpuidex(_info, 7, 0);
+            // /arch:AVX512 also enables the cd, bw, dq and vl extensions
+            bool _avx2 = _info[1] & (1 << 5);
+            unsigned int _avx512 = (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31);
+            if ((static_cast<unsigned int>(_info[1]) & _avx512) == _avx512 && _fma && (_xcr0 & 0xE6) == 0xE6)
+                return 16;
+            if (_avx2 && _fma && (_xcr0 & 0x6) == 0x6)
+                return 8;
+            return 4;
+#else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma"))
+                return 16;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                return 8;
+            return 4;
+#endif
+        }
+    }
+
+    int Lanes()
+    {
+        static const int _lanes = Detect();
+        return _lanes;
+    }
+}
@@ -0,0 +1,288 @@
+#pragma once
+#include <cstring>
+
+#if defined(SYNTHMAKR_SIMD_X86)
+#include <immintrin.h>
+#endif
+
+// Thin vector types for the simd kernels, one instruction set per translation unit. 
+// Everything lives in an anonymous namespace, so code built for a wider instruction 
+// set is never shared with another translation unit.
+namespace
+{
+    // Plain arrays, for cpus without a supported instruction set
+    struct Generic
+    {
+        constexpr static int N = 4;
+        struct F { float v[N]; };
+        struct I { int v[N]; };
+        struct M { bool v[N]; };
+
+#define SYNTHMAKR_LANES(type, expr) type _r; for (int i = 0; i < N; i++) _r.v[i] = expr; return _r
+        static F Set(float x) { SYNTHMAKR_LANES(F, x); }
+        static I SetI(int x) { SYNTHMAKR_LANES(I, x); }
+        static F Load(const float* p) { SYNTHMAKR_LANES(F, p[i]); }
+        static I LoadI(const int* p) { SYNTHMAKR_LANES(I, p[i]); }
+        static void Store(float* p, F a) { for (int i = 0; i < N; i++) p[i] = a.v[i]; }
+        static F Add(F a, F b) { SYNTHMAKR_LANES(F, a.v[i] + b.v[i]); }
+        static F Sub(F a, F b) { SYNTHMAKR_LANES(F, a.v[i] - b.v[i]); }
+        static F Mul(F a, F b) { SYNTHMAKR_LANES(F, a.v[i] * b.v[i]); }
+        static F Div(F a, F b) { SYNTHMAKR_LANES(F, a.v[i] / b.v[i]); }
+        static F Min(F a, F b) { SYNTHMAKR_LANES(F, a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+        static F Max(F a, F b) { SYNTHMAKR_LANES(F, a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+        static M Lt(F a, F b) { SYNTHMAKR_LANES(M, a.v[i] < b.v[i]); }
+        static M Le(F a, F b) { SYNTHMAKR_LANES(M, a.v[i] <= b.v[i]); }
+        static M And(M a, M b) { SYNTHMAKR_LANES(M, a.v[i] && b.v[i]); }
+        static M Or(M a, M b) { SYNTHMAKR_LANES(M, a.v[i] || b.v[i]); }
+        static M Not(M a) { SYNTHMAKR_LANES(M, !a.v[i]); }
+        static F Select(M m, F a, F b) { SYNTHMAKR_LANES(F, m.v[i] ? a.v[i] : b.v[i]); }
+        static I ToInt(F a) { SYNTHMAKR_LANES(I, static_cast<int>(a.v[i])); }
+        static F ToFloat(I a) { SYNTHMAKR_LANES(F, static_cast<float>(a.v[i])); }
+        static I AddI(I a, I b) { SYNTHMAKR_LANES(I, a.v[i] + b.v[i]); }
+        static I AndI(I a, I b) { SYNTHMAKR_LANES(I, a.v[i] & b.v[i]); }
+        static I OrI(I a, I b) { SYNTHMAKR_LANES(I, a.v[i] | b.v[i]); }
+        template<int S> static I Shl(I a) { SYNTHMAKR_LANES(I, a.v[i] << S); }
+        template<int S> static I Shr(I a) { SYNTHMAKR_LANES(I, static_cast<int>(static_cast<unsigned>(a.v[i]) >> S)); }
+        static I AsInt(F a) { I _r; std::memcpy(&_r, &a, sizeof(_r)); return _r; }
+        static F AsFloat(I a) { F _r; std::memcpy(&_r, &a, sizeof(_r)); return _r; }
+        static F Gather(const float* p, I idx) { SYNTHMAKR_LANES(F, p[idx.v[i]]); }
+#undef SYNTHMAKR_LANES
+    };
+
+#if defined(SYNTHMAKR_SIMD_X86)
+    struct Sse
+    {
+        constexpr static int N = 4;
+        using F = __m128;
+        using I = __m128i;
+        using M = __m128;
+
+        static F Set(float x) { return _mm_set1_ps(x); }
+        static I SetI(int x) { return _mm_set1_epi32(x); }
+        static F Load(const float* p) { return _mm_loadu_ps(p); }
+        static I LoadI(const int* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+        static F Add(F a, F b) { return _mm_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm_div_ps(a, b); }
+        static F Min(F a, F b) { return _mm_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm_max_ps(a, b); }
+        static M Lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+        static M Le(F a, F b) { return _mm_cmple_ps(a, b); }
+        static M And(M a, M b) { return _mm_and_ps(a, b); }
+        static M Or(M a, M b) { return _mm_or_ps(a, b); }
+        static M Not(M a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+        static F Select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+        static I ToInt(F a) { return _mm_cvttps_epi32(a); }
+        static F ToFloat(I a) { return _mm_cvtepi32_ps(a); }
+        static I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+        static I AndI(I a, I b) { return _mm_and_si128(a, b); }
+        static I OrI(I a, I b) { return _mm_or_si128(a, b); }
+        template<int S> static I Shl(I a) { return _mm_slli_epi32(a, S); }
+        template<int S> static I Shr(I a) { return _mm_srli_epi32(a, S); }
+        static I AsInt(F a) { return _mm_castps_si128(a); }
+        static F AsFloat(I a) { return _mm_castsi128_ps(a); }
+        static F Gather(const float* p, I idx)
+        {
+            alignas(16) int _i[N];
+            _mm_store_si128(reinterpret_cast<__m128i*>(_i), idx);
+            return _mm_setr_ps(p[_i[0]], p[_i[1]], p[_i[2]], p[_i[3]]);
+        }
+    };
+
+#if defined(__AVX2__)
+    struct Avx2
+    {
+        constexpr static int N = 8;
+        using F = __m256;
+        using I = __m256i;
+        using M = __m256;
+
+        static F Set(float x) { return _mm256_set1_ps(x); }
+        static I SetI(int x) { return _mm256_set1_epi32(x); }
+        static F Load(const float* p) { return _mm256_loadu_ps(p); }
+        static I LoadI(const int* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void Store(float* p, F a) { _mm256_storeu_ps(p, a); }
+        static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+        static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+        static M Lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static M Le(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        static M And(M a, M b) { return _mm256_and_ps(a, b); }
+        static M Or(M a, M b) { return _mm256_or_ps(a, b); }
+        static M Not(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+        static F Select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+        static I ToInt(F a) { return _mm256_cvttps_epi32(a); }
+        static F ToFloat(I a) { return _mm256_cvtepi32_ps(a); }
+        static I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+        static I AndI(I a, I b) { return _mm256_and_si256(a, b); }
+        static I OrI(I a, I b) { return _mm256_or_si256(a, b); }
+        template<int S> static I Shl(I a) { return _mm256_slli_epi32(a, S); }
+        template<int S> static I Shr(I a) { return _mm256_srli_epi32(a, S); }
+        static I AsInt(F a) { return _mm256_castps_si256(a); }
+        static F AsFloat(I a) { return _mm256_castsi256_ps(a); }
+        static F Gather(const float* p, I idx) { return _mm256_i32gather_ps(p, idx, 4); }
+    };
+#endif
+
+#if defined(__AVX512F__)
+    struct Avx512
+    {
+        constexpr static int N = 16;
+        using F = __m512;
+        using I = __m512i;
+        using M = __mmask16;
+
+        static F Set(float x) { return _mm512_set1_ps(x); }
+        static I SetI(int x) { return _mm512_set1_epi32(x); }
+        static F Load(const float* p) { return _mm512_loadu_ps(p); }
+        static I LoadI(const int* p) { return _mm512_loadu_si512(p); }
+        static void Store(float* p, F a) { _mm512_storeu_ps(p, a); }
+        static F Add(F a, F b) { return _mm512_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm512_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm512_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm512_div_ps(a, b); }
+        static F Min(F a, F b) { return _mm512_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm512_max_ps(a, b); }
+        static M Lt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static M Le(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+        static M And(M a, M b) { return static_cast<M>(a & b); }
+        static M Or(M a, M b) { return static_cast<M>(a | b); }
+        static M Not(M a) { return static_cast<M>(~a); }
+        static F Select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+        static I ToInt(F a) { return _mm512_cvttps_epi32(a); }
+        static F ToFloat(I a) { return _mm512_cvtepi32_ps(a); }
+        static I AddI(I a, I b) { return _mm512_add_epi32(a, b); }
+        static I AndI(I a, I b) { return _mm512_and_si512(a, b); }
+        static I OrI(I a, I b) { return _mm512_or_si512(a, b); }
+        template<int S> static I Shl(I a) { return _mm512_slli_epi32(a, S); }
+        template<int S> static I Shr(I a) { return _mm512_srli_epi32(a, S); }
+        static I AsInt(F a) { return _mm512_castps_si512(a); }
+        static F AsFloat(I a) { return _mm512_castsi512_ps(a); }
+        static F Gather(const float* p, I idx) { return _mm512_i32gather_ps(idx, p, 4); }
+    };
+#endif
+#endif
+
+    // Operators on top of an instruction set
+    template<class Isa>
+    struct Mask
+    {
+        typename Isa::M m;
+
+        friend Mask operator&(Mask a, Mask b) { return { Isa::And(a.m, b.m) }; }
+        friend Mask operator|(Mask a, Mask b) { return { Isa::Or(a.m, b.m) }; }
+        friend Mask operator!(Mask a) { return { Isa::Not(a.m) }; }
+    };
+
+    template<class Isa>
+    struct Int
+    {
+        typename Isa::I v;
+
+        Int(typename Isa::I x) : v(x) {}
+        Int(int x) : v(Isa::SetI(x)) {}
+
+        static Int Load(const int* p) { return Isa::LoadI(p); }
+
+        friend Int operator+(Int a, Int b) { return Isa::AddI(a.v, b.v); }
+        friend Int operator&(Int a, Int b) { return Isa::AndI(a.v, b.v); }
+        friend Int operator|(Int a, Int b) { return Isa::OrI(a.v, b.v); }
+        template<int S> Int Shl() const { return Isa::template Shl<S>(v); }
+        template<int S> Int Shr() const { return Isa::template Shr<S>(v); }
+    };
+
+    template<class Isa>
+    struct Float
+    {
+        constexpr static int N = Isa::N;
+        typename Isa::F v;
+
+        Float(typename Isa::F x) : v(x) {}
+        Float(float x) : v(Isa::Set(x)) {}
+
+        static Float Load(const float* p) { return Isa::Load(p); }
+        void Store(float* p) const { Isa::Store(p, v); }
+
+        friend Float operator+(Float a, Float b) { return Isa::Add(a.v, b.v); }
+        friend Float operator-(Float a, Float b) { return Isa::Sub(a.v, b.v); }
+        friend Float operator*(Float a, Float b) { return Isa::Mul(a.v, b.v); }
+        friend Float operator/(Float a, Float b) { return Isa::Div(a.v, b.v); }
+        friend Mask<Isa> operator<(Float a, Float b) { return { Isa::Lt(a.v, b.v) }; }
+        friend Mask<Isa> operator<=(Float a, Float b) { return { Isa::Le(a.v, b.v) }; }
+        friend Mask<Isa> operator>(Float a, Float b) { return { Isa::Lt(b.v, a.v) }; }
+        friend Mask<Isa> operator>=(Float a, Float b) { return { Isa::Le(b.v, a.v) }; }
+    };
+
+    template<class Isa> Float<Isa> Select(Mask<Isa> m, Float<Isa> a, Float<Isa> b) { return Isa::Select(m.m, a.v, b.v); }
+    template<class Isa> Float<Isa> Min(Float<Isa> a, Float<Isa> b) { return Isa::Min(a.v, b.v); }
+    template<class Isa> Float<Isa> Max(Float<Isa> a, Float<Isa> b) { return Isa::Max(a.v, b.v); }
+    template<class Isa> Int<Isa> ToInt(Float<Isa> a) { return Isa::ToInt(a.v); }
+    template<class Isa> Float<Isa> ToFloat(Int<Isa> a) { return Isa::ToFloat(a.v); }
+    template<class Isa> Int<Isa> AsInt(Float<Isa> a) { return Isa::AsInt(a.v); }
+    template<class Isa> Float<Isa> AsFloat(Int<Isa> a) { return Isa::AsFloat(a.v); }
+    template<class Isa> Float<Isa> Gather(const float* p, Int<Isa> idx) { return Isa::Gather(p, idx.v); }
+
+    template<class Isa> 
+    float Sum(Float<Isa> a)
+    {
+        float _lanes[Isa::N];
+        a.Store(_lanes);
+        float _sum = 0;
+        for (int i = 0; i < Isa::N; i++)
+            _sum += _lanes[i];
+        return _sum;
+    }
+
+    // Rounds towards negative infinity, for values that fit in an int
+    template<class Isa>
+    Float<Isa> Floor(Float<Isa> x)
+    {
+        Float<Isa> _t = ToFloat(ToInt(x));
+        return Select(_t > x, _t - 1.f, _t);
+    }
+
+    // log2 from the exponent bits and an atanh series of the mantissa
+    template<class Isa>
+    Float<Isa> Log2(Float<Isa> x)
+    {
+        Int<Isa> _bits = AsInt(x);
+        Float<Isa> _exponent = ToFloat((_bits.template Shr<23>() & 255) + -127);
+        Float<Isa> _m = AsFloat((_bits & 0x007FFFFF) | 0x3F800000);
+        Float<Isa> _t = (_m - 1.f) / (_m + 1.f);
+        Float<Isa> _t2 = _t * _t;
+        Float<Isa> _atanh = _t * (_t2 * (_t2 * (_t2 * (_t2 * (1 / 9.f) + 1 / 7.f) + 1 / 5.f) + 1 / 3.f) + 1.f);
+        return _exponent + _atanh * 2.88539008f; // 2 / ln(2)
+    }
+
+    // exp2 from the exponent bits and a polynomial of the fraction
+    template<class Isa>
+    Float<Isa> Exp2(Float<Isa> x)
+    {
+        x = Max(x, Float<Isa>{ -126.f });
+        Float<Isa> _floor = Floor(x);
+        Float<Isa> _f = (x - _floor) * 0.693147181f; // ln(2)
+        Float<Isa> _exp = _f * (_f * (_f * (_f * (_f * (_f * (_f * (1 / 5040.f) + 1 / 720.f) + 1 / 120.f) + 1 / 24.f) + 1 / 6.f) + 1 / 2.f) + 1.f) + 1.f;
+        return _exp * AsFloat((ToInt(_floor) + 127).template Shl<23>());
+    }
+
+    // x to the power of y for x between 0 and 1
+    template<class Isa>
+    Float<Isa> Pow(Float<Isa> x, Float<Isa> y)
+    {
+        Float<Isa> _pow = Exp2(y * Log2(Max(x, Float<Isa>{ 1e-30f })));
+        return Select(x > 0.f, _pow, Float<Isa>{ 0.f });
+    }
+
+    // sin for x between -pi/2 and pi/2
+    template<class Isa>
+    Float<Isa> Sin(Float<Isa> x)
+    {
+        Float<Isa> _x2 = x * x;
+        return x * (1.f - _x2 * (1 / 6.f - _x2 * (1 / 120.f - _x2 * (1 / 5040.f - _x2 * (1 / 362880.f - _x2 * (1 / 39916800.f))))));
+    }
+}
@@ -0,0 +1,172 @@
+#include "SimdVoices.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+
+static_assert(VoiceLanes::TABLE_SIZE == MipmapWavetable::SIZE);
+
+namespace
+{
+    VoiceLanes::EnvelopeParams Params(const ADSR::Settings& s, double sampleRate)
+    {
+        return {
+            .attack = static_cast<float>(s.attack * sampleRate),
+            .decay = static_cast<float>(s.decay * sampleRate),
+            .sustain = static_cast<float>(s.sustain),
+            .release = static_cast<float>(s.release * sampleRate),
+            .attackCurve = static_cast<float>(s.attackCurve),
+            .decayCurve = static_cast<float>(s.decayCurve),
+            .releaseCurve = static_cast<float>(s.releaseCurve),
+        };
+    }
+}
+
+void SimdVoices::Init()
+{
+    int _supported = Simd::Lanes();
+    m_Lanes = settings.lanes == 0 ? _supported : std::min({ settings.lanes, _supported, MAX_LANES });
+    m_Lanes = m_Lanes >= 16 ? 16 : m_Lanes >= 8 ? 8 : 4;
+
+    // Pad to the widest lane count, padding lanes stay idle
+    int _count = (settings.voices + MAX_LANES - 1) / MAX_LANES * MAX_LANES;
+    m_State.count = _count;
+
+    constexpr int FLOATS = 14, INTS = 1;
+    m_Floats.assign(_count * FLOATS, 0);
+    m_Ints.assign(_count * INTS, 0);
+
+    float* _f = m_Floats.data();
+    int* _i = m_Ints.data();
+    auto _floats = [&] { float* _p = _f; _f += _count; return _p; };
+    auto _ints = [&] { int* _p = _i; _i += _count; return _p; };
+
+    m_State.phase = _floats(), m_State.delta = _floats(), m_State.blend = _floats(), m_State.table = _ints();
+    m_State.gain = { .time = _floats(), .level = _floats(), .down = _floats(), .gate = _floats() };
+    m_State.filter = { .time = _floats(), .level = _floats(), .down = _floats(), .gate = _floats() };
+    m_State.lfoPhase = _floats(), m_State.z1 = _floats(), m_State.z2 = _floats();
+
+    std::fill_n(m_State.gain.time, _count, -1.f);
+    std::fill_n(m_State.filter.time, _count, -1.f);
+
+    m_Tables = MipmapWavetable::Get(settings.wavetable, 0);
+    m_LfoTables = MipmapWavetable::Get(settings.lfo.wavetable, 0);
+    m_State.tables = m_Tables->Data();
+    m_State.lfoTable = m_LfoTables->Data();
+
+    m_Allocator = VoiceAllocator{ { .policy = settings.stealing } };
+    m_Allocator.Voices(settings.voices);
+}
+
+void SimdVoices::Prepare(double sampleRate, int maxBlockSize, int channels)
+{
+    Module::Prepare(sampleRate, maxBlockSize, channels);
+    m_Mix.assign(maxBlockSize, 0);
+}
+
+void SimdVoices::Update()
+{
+    m_State.sampleRate = m_SampleRate;
+    m_State.gainParams = Params(settings.gain, m_SampleRate);
+    m_State.filterParams = Params(settings.filter, m_SampleRate);
+    m_State.lfoFrequency = settings.lfo.frequency;
+    m_State.lfoEnvelope = settings.lfo.envelope;
+    m_State.cutoff = settings.lowpass.frequency;
+    m_State.cutoffEnvelope = settings.lowpass.envelope;
+    m_State.cutoffLfo = settings.lowpass.lfo;
+    m_State.resonance = settings.lowpass.resonance;
+    m_State.mix = settings.lowpass.mix;
+    m_Allocator.settings.policy = settings.stealing;
+}
+
+void SimdVoices::Gate(VoiceLanes::Envelope& env, const ADSR::Settings& s, int voice, bool g)
+{
+    // Same as ADSR::Gate, in samples
+    float& _time = env.time[voice];
+    float _ad = (s.attack + s.decay) * m_SampleRate;
+    if (env.gate[voice] && !g)
+    {
+        _time = _ad;
+        env.down[voice] = env.level[voice];
+    }
+    else if (!env.gate[voice] && g)
+    {
+        env.down[voice] = s.sustain;
+        _time = 0;
+    }
+    else if (!s.legato)
+        _time = 0;
+
+    env.gate[voice] = g;
+}
+
+void SimdVoices::NotePress(int note, int)
+{
+    int voice = m_Allocator.Press(note, [&](int i) { return m_State.gain.level[i]; });
+    if (voice == -1)
+        return;
+
+    double _delta = noteToFreq(note) / m_SampleRate;
+    m_State.delta[voice] = _delta;
+    int _table = MipmapWavetable::Select(_delta, m_State.blend[voice]);
+    if (_table == MipmapWavetable::TABLES - 1) // Kernel always reads 2 tables
+        _table--, m_State.blend[voice] = 1;
+    m_State.table[voice] = _table * (MipmapWavetable::SIZE + 1);
+
+    Gate(m_State.gain, settings.gain, voice, true);
+    Gate(m_State.filter, settings.filter, voice, true);
+}
+
+void SimdVoices::NoteRelease(int note)
+{
+    m_Allocator.Release(note, [&](int voice) {
+        Gate(m_State.gain, settings.gain, voice, false);
+        Gate(m_State.filter, settings.filter, voice, false);
+    });
+}
+
+int SimdVoices::Active() const
+{
+    int _active = 0;
+    for (int i = 0; i < settings.voices; i++)
+        _active += m_State.gain.time[i] >= 0 || m_State.filter.time[i] >= 0;
+    return _active;
+}
+
+void SimdVoices::Render(float* out, int frames)
+{
+    Update();
+    switch (m_Lanes)
+    {
+    case 16: ProcessVoiceLanes16(m_State, 0, m_State.count, out, frames); break;
+    case 8: ProcessVoiceLanes8(m_State, 0, m_State.count, out, frames); break;
+    default: ProcessVoiceLanes4(m_State, 0, m_State.count, out, frames); break;
+    }
+
+    // Voices that finished their release can be used before stealing
+    for (int i = 0; i < settings.voices; i++)
+        if (m_State.gain.time[i] < 0 && m_State.filter.time[i] < 0)
+            m_Allocator.Done(i);
+}
+
+void SimdVoices::Generate()
+{
+    m_Sample = 0;
+    Render(&m_Sample, 1);
+}
+
+void SimdVoices::ProcessBlock(std::span<Sample> block, int channels)
+{
+    // Voices are mono, render once and add to every channel. Blocks larger
+    // than the prepared size are rendered in parts.
+    std::size_t _frames = block.size() / channels;
+    for (std::size_t i = 0; i < _frames && !m_Mix.empty(); i += m_Mix.size())
+    {
+        std::size_t _size = std::min(m_Mix.size(), _frames - i);
+        std::fill_n(m_Mix.begin(), _size, 0);
+        Render(m_Mix.data(), _size);
+
+        for (std::size_t j = 0; j < _size; j++)
+            for (int c = 0; c < channels; c++)
+                block[(i + j) * channels + c] += m_Mix[j];
+    }
+}
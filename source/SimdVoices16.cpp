@@ -0,0 +1,10 @@
+#include "SimdVoicesKernel.hpp"
+
+void ProcessVoiceLanes16(VoiceLanes& lanes, int first, int last, float* out, int frames)
+{
+#if defined(__AVX512F__)
+    ProcessLanes<Avx512>(lanes, first, last, out, frames);
+#else
+    ProcessLanes<Generic>(lanes, first, last, out, frames); // Only called when the cpu supports it
+#endif
+}
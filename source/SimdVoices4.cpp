@@ -0,0 +1,10 @@
+#include "SimdVoicesKernel.hpp"
+
+void ProcessVoiceLanes4(VoiceLanes& lanes, int first, int last, float* out, int frames)
+{
+#if defined(SYNTHMAKR_SIMD_X86)
+    ProcessLanes<Sse>(lanes, first, last, out, frames);
+#else
+    ProcessLanes<Generic>(lanes, first, last, out, frames);
+#endif
+}
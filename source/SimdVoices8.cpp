@@ -0,0 +1,10 @@
+#include "SimdVoicesKernel.hpp"
+
+void ProcessVoiceLanes8(VoiceLanes& lanes, int first, int last, float* out, int frames)
+{
+#if defined(__AVX2__)
+    ProcessLanes<Avx2>(lanes, first, last, out, frames);
+#else
+    ProcessLanes<Generic>(lanes, first, last, out, frames); // Only called when the cpu supports it
+#endif
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "VoiceLanes.hpp"
+#include "SimdVec.hpp"
+
+// Voice lane kernel, included by one translation unit per instruction set.
+namespace
+{
+    constexpr float PI = 3.14159265358979f;
+    constexpr int TABLE_SIZE = VoiceLanes::TABLE_SIZE;
+
+    // Step the envelope and return its level, same curves as ADSR::Generate.
+    template<class Isa>
+    Float<Isa> Envelope(Float<Isa>& time, Float<Isa> down, Float<Isa> gate, const VoiceLanes::EnvelopeParams& p)
+    {
+        using F = Float<Isa>;
+        const F _attack = p.attack, _ad = p.attack + p.decay, _adr = p.attack + p.decay + p.release;
+
+        Mask<Isa> _gate = gate > 0.f;
+        Mask<Isa> _running = (time >= 0.f) & ((time < _ad) | !_gate);
+        F _t = Select(_running, time + 1.f, Select(_gate, _ad, time));
+        _t = Select(_t > _adr, F{ -1.f }, _t);
+        time = _t;
+
+        F _a = Pow(_t / _attack, F{ p.attackCurve });
+        F _d = 1.f - (1.f - p.sustain) * Pow((_t - _attack) / p.decay, F{ p.decayCurve });
+        F _r = down - down * Pow((_t - _ad) / p.release, F{ p.releaseCurve });
+        F _level = Select(_t < _adr, _r, F{ 0.f });
+        _level = Select(_t <= _ad, _d, _level);
+        _level = Select(_t < _attack, _a, _level);
+        return Select(_t < 0.f, F{ 0.f }, _level);
+    }
+
+    // Linear interpolation in a table with a guard sample
+    template<class Isa>
+    Float<Isa> Lookup(const float* table, Int<Isa> offset, Float<Isa> phase)
+    {
+        Float<Isa> _pos = phase * static_cast<float>(TABLE_SIZE);
+        Int<Isa> _index = ToInt(_pos);
+        Float<Isa> _frac = _pos - ToFloat(_index);
+        Int<Isa> _i = offset + _index;
+        Float<Isa> _a = Gather(table, _i);
+        Float<Isa> _b = Gather(table + 1, _i);
+        return _a + (_b - _a) * _frac;
+    }
+
+    template<class Isa>
+    void ProcessLanes(VoiceLanes& v, int first, int last, float* out, int frames)
+    {
+        using F = Float<Isa>;
+        using I = Int<Isa>;
+        constexpr int N = Isa::N;
+
+        const F _dt = 1 / v.sampleRate;
+        const F _minCutoff = 10.f, _maxCutoff = v.sampleRate / 2.1f;
+        const F _w = 2 * PI / v.sampleRate;
+        const F _q = 1 / (2 * v.resonance);
+        const F _lfoFrequency = v.lfoFrequency, _lfoEnvelope = v.lfoEnvelope;
+        const F _cutoff = v.cutoff, _cutoffEnvelope = v.cutoffEnvelope, _cutoffLfo = v.cutoffLfo;
+        const F _mix = v.mix, _dry = 1 - v.mix;
+        const I _next = TABLE_SIZE + 1;
+
+        for (int l = first; l < last; l += N)
+        {
+            // Skip lanes where every voice is done
+            bool _active = false;
+            for (int i = 0; i < N; i++)
+                _active |= v.gain.time[l + i] >= 0 || v.filter.time[l + i] >= 0;
+            if (!_active)
+                continue;
+
+            F _phase = F::Load(v.phase + l), _delta = F::Load(v.delta + l), _blend = F::Load(v.blend + l);
+            I _table = I::Load(v.table + l);
+            F _gainTime = F::Load(v.gain.time + l), _gainDown = F::Load(v.gain.down + l), _gainGate = F::Load(v.gain.gate + l);
+            F _filterTime = F::Load(v.filter.time + l), _filterDown = F::Load(v.filter.down + l), _filterGate = F::Load(v.filter.gate + l);
+            F _gain = F::Load(v.gain.level + l), _env = F::Load(v.filter.level + l);
+            F _lfoPhase = F::Load(v.lfoPhase + l), _z1 = F::Load(v.z1 + l), _z2 = F::Load(v.z2 + l);
+
+            for (int f = 0; f < frames; f++)
+            {
+                _gain = Envelope(_gainTime, _gainDown, _gainGate, v.gainParams);
+                _env = Envelope(_filterTime, _filterDown, _filterGate, v.filterParams);
+
+                // Lfo
+                F _lfo = Lookup(v.lfoTable, I{ 0 }, _lfoPhase);
+                _lfoPhase = _lfoPhase + (_lfoFrequency + _lfoEnvelope * _env) * _dt;
+                _lfoPhase = _lfoPhase - Floor(_lfoPhase);
+
+                // Oscillator, blended between 2 mip-mapped tables
+                F _s1 = Lookup(v.tables, _table, _phase);
+                F _s2 = Lookup(v.tables, _table + _next, _phase);
+                F _osc = _s1 + (_s2 - _s1) * _blend;
+                _phase = _phase + _delta;
+                _phase = _phase - Floor(_phase);
+
+                // Lowpass coefficients, same as BiquadParameters
+                F _fc = _cutoff + _cutoffEnvelope * _env * _env + _cutoffLfo * _lfo;
+                F _w0 = Min(Max(_fc, _minCutoff), _maxCutoff) * _w;
+                F _sin = Sin(Select(_w0 > PI / 2, PI - _w0, _w0));
+                F _cos = Sin(PI / 2 - _w0);
+                F _alpha = _sin * _q;
+                F _a0 = 1.f / (1.f + _alpha);
+                F _b1 = (1.f - _cos) * _a0;
+                F _b0 = _b1 * 0.5f;
+                F _a1 = -2.f * _cos * _a0;
+                F _a2 = (1.f - _alpha) * _a0;
+
+                // Transposed direct form II
+                F _x = _osc * _gain;
+                F _y = _b0 * _x + _z1;
+                _z1 = _b1 * _x - _a1 * _y + _z2;
+                _z2 = _b0 * _x - _a2 * _y;
+
+                out[f] += Sum(_y * _mix + _x * _dry);
+            }
+
+            _phase.Store(v.phase + l), _lfoPhase.Store(v.lfoPhase + l), _z1.Store(v.z1 + l), _z2.Store(v.z2 + l);
+            _gainTime.Store(v.gain.time + l), _gain.Store(v.gain.level + l);
+            _filterTime.Store(v.filter.time + l), _env.Store(v.filter.level + l);
+        }
+    }
+}
@@ -1,120 +1,29 @@
 #include "Synth.hpp"
 
-Sample Synth::VoiceBase::m_Process(Sample sample, Channel channel)
-{
-    for (auto& i : m_Modules)
-        i->Generate(channel);
-
-    return m_Chain(sample, channel);
-}
-
-void Synth::VoiceBank::NotePress(int note, int velocity)
-{
-    // Release the longest held note
-    if (m_Available.size() == 0)
-    {
-        int longestheld = m_Pressed.back();
-        m_Pressed.pop_back();
-
-        // Set note to -1 and emplace to available.
-        m_Notes[longestheld] = -1;
-        m_Available.emplace(m_Available.begin(), longestheld);
-    }
-
-    // Get an available voice
-    if (!m_Available.empty())
-    {
-        int voice = m_Available.back();
-        m_Available.pop_back();
-
-        // Emplace it to pressed voices queue
-        m_Pressed.emplace(m_Pressed.begin(), voice);
-
-        // Set voice to note
-        m_Notes[voice] = note;
-        m_GeneratorVoices[voice]->NotePress(note, velocity);
-    }
-}
-
-void Synth::VoiceBank::NoteRelease(int note, int velocity)
-{
-    // Find the note in the pressed notes per voice
-    while (true)
-    {
-        auto it = std::find(m_Notes.begin(), m_Notes.end(), note);
-        if (it != m_Notes.end())
-        {
-            // If it was pressed, get the voice index
-            int voice = std::distance(m_Notes.begin(), it);
-
-            // Set note to -1 and emplace to available.
-            m_GeneratorVoices[voice]->NoteRelease(note);
-            m_Notes[voice] = -1;
-            m_Available.emplace(m_Available.begin(), voice);
-
-            // Erase it from the pressed queue
-            auto it2 = std::find(m_Pressed.begin(), m_Pressed.end(), voice);
-            if (it2 != m_Pressed.end())
-                m_Pressed.erase(it2);
-        }
-        else break;
-    }
-}
-
-Sample Synth::VoiceBank::Process(Sample sample, Channel channel)
-{
-    Sample out = 0;
-    for (auto& voice : m_GeneratorVoices)
-    {
-        if (!voice->Done())
-        {
-            for (auto& j : voice->m_Modules)
-                j->Generate(channel);
-
-            voice->Mod();
-            if (voice->m_Chain)
-                out += voice->m_Chain(sample, channel);
-        }
-    }
-    return out;
-}
+#include <fstream>
 
 Synth::Synth(const Settings& s)
-    : settings(s), m_Stream(), Frame{ {.name = s.name } }
+    : settings(s), Frame{ {.name = s.name } }
 {
+    // Midi comes in through the backend, the notes are sent to the engine
+    Backend::Settings _audio{ .sampleRate = 48000, .bufferSize = 512 };
+    m_Audio = s.backend == "wasapi" ? std::make_unique<AudijoBackend>(_audio) : Backend::Create(s.backend, _audio);
+
+    Trace::Name("Gui");
     titlebar.close.color.base.a = 0;
     titlebar.minimize.color.base.a = 0;
     titlebar.maximize.color.base.a = 0;
 
     *this += [this](const KeyPress& e) {
         if (!e.repeat && keyboard2midi.contains(e.keycode))
-            m_Voices.NotePress(keyboard2midi[e.keycode] + 48, 127);
+            Send({ .type = Engine::Event::Press, .note = keyboard2midi[e.keycode] + 48 });
     };
 
     *this += [this](const KeyRelease& e) {
         if (keyboard2midi.contains(e.keycode))
-            m_Voices.NoteRelease(keyboard2midi[e.keycode] + 48, 127);
+            Send({ .type = Engine::Event::Release, .note = keyboard2midi[e.keycode] + 48 });
     };
 
-    m_Stream.Callback([&](Buffer<Sample>&, Buffer<Sample>& out, CallbackInfo info)
-    {
-        Module::SAMPLE_RATE = info.sampleRate;
-        for (auto& i : out)
-        {
-            int channel = 0;
-            for (auto& j : i)
-                j = this->m_Process(0, channel++);
-        }
-    });
-
-    m_Midi.Callback([this](const NoteOn& e) {
-        m_Voices.NotePress(e.RawNote(), e.Velocity());
-    });
-
-    m_Midi.Callback([this](const NoteOff& e) {
-        m_Voices.NoteRelease(e.RawNote(), e.Velocity());
-    });
-
     GuiCode::Button& _b1 = titlebar.menu.emplace_back<GuiCode::Button>({
         .name = "Audio",
         .graphics = new MenuButton
@@ -139,12 +48,36 @@ Synth::Synth(const Settings& s)
 
     _b3 += [this](const Unfocus&) { ContextMenu::Close(m_Menu2); };
 
+    // Module time is only measured while the overlay is shown
+    GuiCode::Button& _b5 = titlebar.menu.emplace_back<GuiCode::Button>({
+        .name = "Monitor",
+        .graphics = new MenuButton
+    });
+
+    m_Monitor.State(Visible) = false;
+    _b5.settings.callback = [this](bool v) {
+        m_Monitor.State(Visible) = v;
+        Monitor::TimeModules(v);
+    };
+
+    // Records while pressed, the trace is written when released
+    GuiCode::Button& _b6 = titlebar.menu.emplace_back<GuiCode::Button>({
+        .name = "Trace",
+        .graphics = new MenuButton
+    });
+
+    _b6.settings.callback = [](bool v) {
+        if (v)
+            return Trace::Start();
+
+        Trace::Stop();
+        std::ofstream _file{ "trace.json" };
+        Trace::Write(_file);
+    };
+
     GuiCode::Button::Group group;
-    for (auto& i : m_Stream.Devices())
+    for (auto& i : m_Audio ? m_Audio->Devices() : std::vector<Backend::Device>{})
     {
-        if (!i.outputChannels)
-            continue;
-
         GuiCode::Button& _b2 = m_Menu.emplace_back<GuiCode::Button>({
             .group = group,
             .type = GuiCode::Button::Radio,
@@ -152,15 +85,13 @@ Synth::Synth(const Settings& s)
             .graphics = new MenuButton
             });
 
-        _b2.settings.callback = [&](bool b) {
+        _b2.settings.callback = [this, _id = i.id](bool b) {
             if (b)
             {
-                m_Stream.Close();
-                m_Stream.Open({
-                    .input = NoDevice,
-                    .output = i.id,
-                    });
-                m_Stream.Start();
+                // The backend prepares the engine while the device is closed
+                m_Audio->Stop();
+                m_Audio->settings.device = _id;
+                m_Audio->Start(*this);
             }
         };
 
@@ -169,7 +100,8 @@ Synth::Synth(const Settings& s)
     }
 
     GuiCode::Button::Group group2;
-    for (auto& i : m_Midi.Devices())
+    bool _first = true;
+    for (auto& i : m_Audio ? m_Audio->MidiDevices() : std::vector<Backend::Device>{})
     {
         GuiCode::Button& _b4 = m_Menu2.emplace_back<GuiCode::Button>({
             .group = group2,
@@ -178,29 +110,19 @@ Synth::Synth(const Settings& s)
             .graphics = new MenuButton
         });
 
-        _b4.settings.callback = [&](bool b) {
-            if (b)
-            {
-                m_Midi.Close();
-                if (m_Midi.Open({
-                    .device = i.id,
-                }) != Midijo::NoError) _b4.State(Selected) = false;
-            }
+        _b4.settings.callback = [this, &_b4, _id = i.id](bool b) {
+            if (b && !m_Audio->OpenMidi(_id))
+                _b4.State(Selected) = false;
         };
 
-        if (i.id == 0)
-            _b4.State(Selected) = true, _b4.settings.callback(true);
+        // The backend opened the first input when it started
+        if (_first)
+            _b4.State(Selected) = true, _first = false;
     }
 }
 
-Sample Synth::m_Process(Sample sample, Channel channel)
+void Synth::Update()
 {
-    if (!m_Chain)
-        m_Chain = Chain();
-
-    for (auto& i : m_Modules)
-        i->Generate(channel);
-
-    Mod();
-    return m_Chain(m_Voices.Process(sample, channel), channel);
-}
\ No newline at end of file
+    Frame::Update();
+    m_Monitor.dimensions = { x + width - 258, y + height - 178, 250, 170 };
+}
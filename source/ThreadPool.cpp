@@ -0,0 +1,130 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+#include "Trace.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SYNTHMAKR_PAUSE() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#define SYNTHMAKR_PAUSE() __builtin_ia32_pause()
+#else
+#define SYNTHMAKR_PAUSE() std::this_thread::yield()
+#endif
+
+namespace
+{
+    constexpr int SPIN = 20000; // Pauses before a worker parks, a few blocks worth at small buffer sizes
+}
+
+ThreadPool::ThreadPool(int threads)
+    : m_Threads(std::max(threads, 1)), m_Parts(new Part[m_Threads])
+{
+    m_Workers.reserve(m_Threads - 1);
+    for (int i = 1; i < m_Threads; i++)
+        m_Workers.emplace_back([this, i] { m_Worker(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    m_Stop = true;
+    m_Generation.fetch_add(2);
+    m_Generation.notify_all();
+    for (auto& i : m_Workers)
+        i.join();
+}
+
+void ThreadPool::m_Run(std::size_t count, void (*fun)(void*, std::size_t), void* context)
+{
+    if (m_Threads == 1 || count <= 1)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            fun(context, i);
+        return;
+    }
+
+    // Keep workers out while setting up, and wait for workers still in the last job
+    m_Generation.fetch_add(1);
+    while (m_Busy.load() != 0)
+        SYNTHMAKR_PAUSE();
+
+    m_Fun = fun;
+    m_Context = context;
+    m_Remaining.store(static_cast<std::uint32_t>(count), std::memory_order_relaxed);
+    for (int i = 0; i < m_Threads; i++)
+    {
+        m_Parts[i].next.store(count * i / m_Threads, std::memory_order_relaxed);
+        m_Parts[i].end = count * (i + 1) / m_Threads;
+    }
+
+    m_Generation.fetch_add(1, std::memory_order_release);
+    m_Generation.notify_all();
+
+    m_Work(0);
+
+    // Spin for the last indices, then park, so long jobs like batch renders don't
+    // keep this thread busy while the workers finish
+    for (int i = 0;; i++)
+    {
+        std::uint32_t _remaining = m_Remaining.load(std::memory_order_acquire);
+        if (_remaining == 0)
+            break;
+
+        if (i < SPIN)
+            SYNTHMAKR_PAUSE();
+        else
+            m_Remaining.wait(_remaining, std::memory_order_acquire);
+    }
+}
+
+void ThreadPool::m_Work(int thread)
+{
+    // Own part first, then steal from the others
+    for (int i = 0; i < m_Threads; i++)
+    {
+        Part& _part = m_Parts[(thread + i) % m_Threads];
+        while (true)
+        {
+            std::size_t _index = _part.next.fetch_add(1, std::memory_order_relaxed);
+            if (_index >= _part.end)
+                break;
+
+            m_Fun(m_Context, _index);
+            if (m_Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                m_Remaining.notify_one();
+        }
+    }
+}
+
+void ThreadPool::m_Worker(int thread)
+{
+    Trace::Name("Worker");
+    std::uint32_t _seen = 0;
+    while (true)
+    {
+        // Spin for a new job, then park until one arrives
+        std::uint32_t _generation;
+        for (int i = 0;; i++)
+        {
+            _generation = m_Generation.load(std::memory_order_acquire);
+            if (m_Stop)
+                return;
+
+            if (_generation != _seen && !(_generation & 1))
+                break;
+
+            if (i < SPIN)
+                SYNTHMAKR_PAUSE();
+            else
+                m_Generation.wait(_generation);
+        }
+
+        // Only work when the job didn't change in the meantime
+        m_Busy.fetch_add(1);
+        if (m_Generation.load() == _generation)
+            m_Work(thread);
+        m_Busy.fetch_sub(1);
+        _seen = _generation;
+    }
+}
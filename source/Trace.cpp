@@ -0,0 +1,184 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Monitor.hpp"
+
+namespace
+{
+    std::int64_t Nanoseconds()
+    {
+        auto _now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(_now).count();
+    }
+
+    struct Event
+    {
+        std::int64_t time; // Nanoseconds since Start
+        const char* name;
+        int value;
+        char phase;
+        bool type; // Name is a mangled type name
+    };
+
+    struct Ring
+    {
+        std::unique_ptr<Event[]> events;
+        std::size_t mask = 0;
+        std::atomic<std::size_t> position = 0; // Only written by the thread owning the ring
+        std::atomic<bool> writing = false;     // While the owner records, Stop waits for it
+        std::atomic<const char*> name = nullptr;
+    };
+
+    // Rings of the current trace, threads claim a ring the first time they record
+    // in a generation, so a new trace hands out its rings again.
+    std::unique_ptr<Ring[]> rings;
+    int count = 0;
+    std::atomic<int> claimed = 0;
+    std::atomic<int> generation = 0;
+    std::int64_t origin = 0;
+
+    thread_local int t_Generation = -1;
+    thread_local Ring* t_Ring = nullptr;
+    thread_local const char* t_Name = nullptr;
+}
+
+void Trace::Start(const Settings& settings)
+{
+    Stop();
+
+    std::size_t _size = std::bit_ceil(std::max<std::size_t>(settings.events, 2));
+    if (!rings || count != std::max(settings.threads, 1) || rings[0].mask != _size - 1)
+    {
+        count = std::max(settings.threads, 1);
+        rings = std::make_unique<Ring[]>(count);
+        for (int i = 0; i < count; i++)
+        {
+            rings[i].events = std::make_unique<Event[]>(_size);
+            rings[i].mask = _size - 1;
+        }
+    }
+
+    // Nothing records while stopped, so the rings can be reset here
+    for (int i = 0; i < count; i++)
+    {
+        rings[i].position.store(0, std::memory_order_relaxed);
+        rings[i].name.store(nullptr, std::memory_order_relaxed);
+    }
+
+    claimed = 0;
+    origin = Nanoseconds();
+    generation.fetch_add(1, std::memory_order_release);
+    m_Recording.store(true, std::memory_order_release);
+}
+
+void Trace::Start()
+{
+    Start(Settings{});
+}
+
+void Trace::Stop()
+{
+    // Threads that saw the trace recording before it stopped finish their event first
+    m_Recording.store(false, std::memory_order_seq_cst);
+    for (int i = 0; i < count; i++)
+        while (rings[i].writing.load(std::memory_order_seq_cst))
+            std::this_thread::yield();
+}
+
+void Trace::Name(const char* name)
+{
+    t_Name = name;
+    if (t_Ring && t_Generation == generation.load(std::memory_order_acquire))
+        t_Ring->name.store(name, std::memory_order_relaxed);
+}
+
+void Trace::m_Record(const char* name, char phase, int value, bool type)
+{
+    int _generation = generation.load(std::memory_order_acquire);
+    if (t_Generation != _generation)
+    {
+        t_Generation = _generation;
+        int _index = claimed.fetch_add(1, std::memory_order_relaxed);
+        t_Ring = _index < count ? &rings[_index] : nullptr;
+        if (t_Ring)
+            t_Ring->name.store(t_Name, std::memory_order_relaxed);
+    }
+
+    if (!t_Ring)
+        return;
+
+    // Either Stop sees the ring writing and waits, or the event sees the trace stopped
+    t_Ring->writing.store(true, std::memory_order_seq_cst);
+    if (m_Recording.load(std::memory_order_seq_cst))
+    {
+        std::size_t _position = t_Ring->position.load(std::memory_order_relaxed);
+        t_Ring->events[_position & t_Ring->mask] = { Nanoseconds() - origin, name, value, phase, type };
+        t_Ring->position.store(_position + 1, std::memory_order_release);
+    }
+    t_Ring->writing.store(false, std::memory_order_release);
+}
+
+bool Trace::Write(std::ostream& out)
+{
+    out << "{ \"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+
+    bool _first = true;
+    auto _separate = [&] { out << (_first ? "  " : ",\n  "); _first = false; };
+    auto _write = [&](const Event& event, int tid)
+    {
+        _separate();
+        out << "{ \"ph\": \"" << event.phase << "\", \"name\": \""
+            << (event.type ? Monitor::Name(event.name) : event.name)
+            << "\", \"pid\": 1, \"tid\": " << tid << ", \"ts\": " << event.time / 1000
+            << "." << event.time / 100 % 10 << event.time / 10 % 10 << event.time % 10;
+
+        if (event.phase == 'i')
+            out << ", \"s\": \"t\", \"args\": { \"value\": " << event.value << " }";
+        out << " }";
+    };
+
+    int _rings = std::min(claimed.load(std::memory_order_acquire), count);
+    for (int i = 0; i < _rings; i++)
+    {
+        Ring& _ring = rings[i];
+        if (const char* _name = _ring.name.load(std::memory_order_relaxed))
+        {
+            _separate();
+            out << "{ \"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << i
+                << ", \"args\": { \"name\": \"" << _name << "\" } }";
+        }
+
+        // Oldest event first, a full ring starts with the oldest that wasn't overwritten.
+        // Ends whose begin was overwritten are dropped, and scopes that were still open
+        // end with the last event, so the slices of every thread nest.
+        std::size_t _position = _ring.position.load(std::memory_order_acquire);
+        std::size_t _size = _ring.mask + 1;
+        std::size_t _start = _position > _size ? _position - _size : 0;
+        std::vector<const Event*> _open;
+        for (std::size_t j = _start; j < _position; j++)
+        {
+            const Event& _event = _ring.events[j & _ring.mask];
+            if (_event.phase == 'E' && _open.empty())
+                continue;
+
+            if (_event.phase == 'B')
+                _open.push_back(&_event);
+            else if (_event.phase == 'E')
+                _open.pop_back();
+            _write(_event, i);
+        }
+
+        std::int64_t _last = _position > _start ? _ring.events[(_position - 1) & _ring.mask].time : 0;
+        for (; !_open.empty(); _open.pop_back())
+            _write({ _last, _open.back()->name, 0, 'E', _open.back()->type }, i);
+    }
+
+    out << "\n] }\n";
+    return static_cast<bool>(out);
+}
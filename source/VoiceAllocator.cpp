@@ -0,0 +1,107 @@
+#include "VoiceAllocator.hpp"
+
+void VoiceAllocator::Voices(int count)
+{
+    int _first = Voices();
+    m_Voices.resize(_first + count);
+    for (int i = _first; i < Voices(); i++)
+        m_Link(m_Idle, i, &Voice::state);
+}
+
+void VoiceAllocator::Done(int voice)
+{
+    if (m_Voices[voice].current == Releasing)
+        m_Move(voice, Idle);
+}
+
+VoiceAllocator::List& VoiceAllocator::m_List(State state)
+{
+    return state == Idle ? m_Idle : state == Held ? m_Held : m_Releasing;
+}
+
+void VoiceAllocator::m_Link(List& list, int voice, Links Voice::* links)
+{
+    Links& _links = m_Voices[voice].*links;
+    _links.prev = -1;
+    _links.next = list.head;
+    if (list.head != -1)
+        (m_Voices[list.head].*links).prev = voice;
+    else
+        list.tail = voice;
+    list.head = voice;
+}
+
+void VoiceAllocator::m_Unlink(List& list, int voice, Links Voice::* links)
+{
+    Links& _links = m_Voices[voice].*links;
+    if (_links.prev != -1)
+        (m_Voices[_links.prev].*links).next = _links.next;
+    else
+        list.head = _links.next;
+
+    if (_links.next != -1)
+        (m_Voices[_links.next].*links).prev = _links.prev;
+    else
+        list.tail = _links.prev;
+
+    _links = {};
+}
+
+void VoiceAllocator::m_Move(int voice, State state)
+{
+    Voice& _voice = m_Voices[voice];
+    m_Unlink(m_List(_voice.current), voice, &Voice::state);
+    _voice.current = state;
+    m_Link(m_List(state), voice, &Voice::state);
+}
+
+int VoiceAllocator::m_Retrigger(int note)
+{
+    if (settings.policy != SameNote)
+        return -1;
+
+    // Oldest voice holding the note, or a released voice that last played it
+    if (int _held = m_Notes[note & 127].tail; _held != -1)
+        return _held;
+
+    int _last = m_Last[note & 127];
+    if (_last != -1 && m_Voices[_last].current == Releasing && m_Voices[_last].note == note)
+        return _last;
+
+    return -1;
+}
+
+int VoiceAllocator::m_Steal()
+{
+    if (settings.policy == ReleasingFirst && m_Releasing.tail != -1)
+        return m_Releasing.tail;
+
+    // Oldest of the oldest held and oldest released voice
+    int _held = m_Held.tail, _released = m_Releasing.tail;
+    if (_held == -1 || _released == -1)
+        return _held == -1 ? _released : _held;
+
+    return m_Voices[_held].start < m_Voices[_released].start ? _held : _released;
+}
+
+void VoiceAllocator::m_Press(int voice, int note)
+{
+    Voice& _voice = m_Voices[voice];
+    if (_voice.held)
+        m_Unlink(m_Notes[_voice.note & 127], voice, &Voice::notes), _voice.held = false;
+
+    m_Move(voice, Held);
+    _voice.note = note;
+    _voice.start = m_Counter++;
+    _voice.held = true;
+    m_Link(m_Notes[note & 127], voice, &Voice::notes);
+    m_Last[note & 127] = voice;
+}
+
+void VoiceAllocator::m_Release(int voice)
+{
+    Voice& _voice = m_Voices[voice];
+    m_Unlink(m_Notes[_voice.note & 127], voice, &Voice::notes);
+    _voice.held = false;
+    m_Move(voice, Releasing);
+}
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "Batch.hpp"
+#include "Patches.hpp"
+
+namespace
+{
+    void Usage()
+    {
+        std::cout
+            << "usage: synthmakr-batch [options]\n"
+            << "  -f <file>      jobs, lines of \"<patch> <events> <output> [rate]\", events like -e of synthmakr-render\n"
+            << "  -p <patches>   render a note per job for these patches, comma separated (default: default)\n"
+            << "  -n <notes>     notes of the jobs, \"<low>-<high>\" (default: 36-84)\n"
+            << "  -v <velocity>  velocities of the jobs, comma separated (default: 100)\n"
+            << "  -l <seconds>   length of the notes (default: 1)\n"
+            << "  -o <dir>       directory for <patch>_<note>_<velocity>.wav, nothing is written when omitted\n"
+            << "  -r <rate>      sample rate of jobs without one (default: 44100)\n"
+            << "  -c <channels>  channel count (default: 2)\n"
+            << "  -b <frames>    block size (default: 512)\n"
+            << "  -t <seconds>   tail after the last event (default: 2)\n"
+            << "  -j <threads>   jobs rendered at once (default: one per core)\n";
+    }
+
+    std::vector<std::string> Split(const std::string& list)
+    {
+        std::vector<std::string> _parts;
+        std::istringstream _stream{ list };
+        for (std::string _part; std::getline(_stream, _part, ',');)
+            if (!_part.empty())
+                _parts.push_back(_part);
+        return _parts;
+    }
+
+    // Events of a job are a midi file or note events, like synthmakr-render
+    bool Events(const std::string& path, Batch::Job& job)
+    {
+        std::ifstream _file{ path, std::ios::binary };
+        char _magic[4]{};
+        if (!_file.read(_magic, 4))
+            return false;
+
+        if (std::string{ _magic, 4 } == "MThd")
+            return job.midi = path, true;
+
+        _file.seekg(0);
+        job.events = ParseEvents(_file);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string _jobs, _patches = "default", _notes = "36-84", _velocities = "100", _output;
+    Batch::Settings _settings;
+    double _length = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string _arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string _value = argv[++i];
+        if (_arg == "-f") _jobs = _value;
+        else if (_arg == "-p") _patches = _value;
+        else if (_arg == "-n") _notes = _value;
+        else if (_arg == "-v") _velocities = _value;
+        else if (_arg == "-l") _length = std::stod(_value);
+        else if (_arg == "-o") _output = _value;
+        else if (_arg == "-r") _settings.render.sampleRate = std::stod(_value);
+        else if (_arg == "-c") _settings.render.channels = std::stoi(_value);
+        else if (_arg == "-b") _settings.render.blockSize = std::stoi(_value);
+        else if (_arg == "-t") _settings.render.tail = std::stod(_value);
+        else if (_arg == "-j") _settings.threads = std::stoi(_value);
+        else return Usage(), 1;
+    }
+
+    std::vector<Batch::Job> _batch;
+    if (!_jobs.empty())
+    {
+        std::ifstream _file{ _jobs };
+        if (!_file)
+        {
+            std::cerr << "can't open jobs: " << _jobs << "\n";
+            return 1;
+        }
+
+        std::string _line;
+        while (std::getline(_file, _line))
+        {
+            std::istringstream _stream{ _line };
+            std::string _patch, _events, _wav;
+            if (_line.empty() || _line[0] == '#' || !(_stream >> _patch >> _events >> _wav))
+                continue;
+
+            if (!patches.contains(_patch))
+            {
+                std::cerr << "unknown patch: " << _patch << "\n";
+                return 1;
+            }
+
+            Batch::Job _job{ .engine = patches[_patch], .output = _wav };
+            _stream >> _job.sampleRate;
+            if (!Events(_events, _job))
+            {
+                std::cerr << "can't open events: " << _events << "\n";
+                return 1;
+            }
+            _batch.push_back(std::move(_job));
+        }
+    }
+    else
+    {
+        // A job per patch, note and velocity
+        int _low = 0, _high = 0;
+        char _dash = 0;
+        std::istringstream _range{ _notes };
+        if (!(_range >> _low) || ((_range >> _dash) && (_dash != '-' || !(_range >> _high))))
+            return Usage(), 1;
+        if (_dash != '-')
+            _high = _low;
+
+        for (auto& _patch : Split(_patches))
+        {
+            if (!patches.contains(_patch))
+            {
+                std::cerr << "unknown patch: " << _patch << "\n";
+                return 1;
+            }
+
+            for (int _note = _low; _note <= _high; _note++)
+                for (auto& _velocity : Split(_velocities))
+                {
+                    Batch::Job _job{ .engine = patches[_patch] };
+                    _job.events.push_back({ .time = 0, .note = _note, .velocity = std::stoi(_velocity), .press = true });
+                    _job.events.push_back({ .time = _length, .note = _note, .velocity = std::stoi(_velocity), .press = false });
+                    if (!_output.empty())
+                        _job.output = _output + "/" + _patch + "_" + std::to_string(_note) + "_" + _velocity + ".wav";
+                    _batch.push_back(std::move(_job));
+                }
+        }
+    }
+
+    Batch _renderer{ _settings };
+    auto _start = std::chrono::steady_clock::now();
+    auto _results = _renderer.Run(_batch);
+    double _elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+    double _seconds = 0, _busy = 0;
+    int _failed = 0;
+    for (auto& i : _results)
+    {
+        _seconds += i.frames / i.sampleRate;
+        _busy += i.seconds;
+        if (!i.error.empty())
+            std::cerr << i.error << "\n", _failed++;
+    }
+
+    // Busy time over elapsed time shows how well the threads were used
+    std::printf("rendered %zu jobs, %.2f s in %.3f s on %d threads, %.1fx real-time, %.2f threads busy\n",
+        _results.size(), _seconds, _elapsed, _renderer.Threads(_batch.size()), _seconds / _elapsed, _busy / _elapsed);
+
+    return _failed ? 1 : 0;
+}
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Graph.hpp"
+#include "Patches.hpp"
+#include "Simd.hpp"
+
+namespace
+{
+    struct Options
+    {
+        double sampleRate = 44100;
+        int channels = 2;
+        int blockSize = 512;  // frames
+        double time = 0.1;    // seconds measured per round
+        int rounds = 5;
+        int maxVoices = 256;
+    };
+
+    struct Result
+    {
+        std::string group;
+        std::string name;
+        double nsPerSample;
+    };
+
+    // Run the function for whole blocks until enough time passed, and return the
+    // nanoseconds per sample of the fastest round, every channel of a frame is a sample.
+    template<class Fun>
+    double Measure(const Options& o, Fun&& fun)
+    {
+        using Clock = std::chrono::steady_clock;
+        double _best = std::numeric_limits<double>::max();
+        for (int i = 0; i < o.rounds + 1; i++)
+        {
+            std::size_t _samples = 0;
+            auto _start = Clock::now();
+            auto _now = _start;
+            do
+            {
+                fun();
+                _samples += static_cast<std::size_t>(o.blockSize) * o.channels;
+                _now = Clock::now();
+            } 
+            while (std::chrono::duration<double>(_now - _start).count() < o.time);
+
+            // First round is warmup
+            if (i != 0)
+                _best = std::min(_best, std::chrono::duration<double, std::nano>(_now - _start).count() / _samples);
+        }
+        return _best;
+    }
+
+    class Bench
+    {
+    public:
+        Bench(const Options& o) 
+            : options(o), m_Input(o.blockSize * o.channels), m_Block(o.blockSize * o.channels)
+        {
+            std::mt19937 _random{ 0 };
+            std::uniform_real_distribution<Sample> _noise{ -1, 1 };
+            for (auto& s : m_Input)
+                s = _noise(_random);
+        }
+
+        Options options;
+        std::vector<Result> results;
+        std::vector<std::pair<std::string, std::size_t>> voiceBytes;
+        int graphBuffers = 0;
+        volatile Sample sink = 0;
+
+        // Benchmark a module on a block of noise
+        void Module(const std::string& name, ::Module& module)
+        {
+            module.Prepare(options.sampleRate, options.blockSize, options.channels);
+            Add("modules", name, [&] {
+                std::copy(m_Input.begin(), m_Input.end(), m_Block.begin());
+                module.ProcessBlock(m_Block, options.channels);
+                sink = m_Block[0];
+            });
+        }
+
+        // Benchmark a block rendering function
+        void Render(const std::string& group, const std::string& name, std::function<void(std::span<Sample>, int)> fun)
+        {
+            Add(group, name, [&] {
+                std::fill(m_Block.begin(), m_Block.end(), 0);
+                fun(m_Block, options.channels);
+                sink = m_Block[0];
+            });
+        }
+
+        std::string Json() const
+        {
+            std::ostringstream _out;
+            _out << "{\n"
+                << "  \"sampleRate\": " << options.sampleRate << ",\n"
+                << "  \"channels\": " << options.channels << ",\n"
+                << "  \"blockSize\": " << options.blockSize << ",\n"
+                << "  \"voiceBytes\": {";
+
+            for (std::size_t i = 0; i < voiceBytes.size(); i++)
+                _out << (i ? ", " : " ") << "\"" << voiceBytes[i].first << "\": " << voiceBytes[i].second;
+
+            _out << " },\n"
+                << "  \"graphBuffers\": " << graphBuffers << ",\n"
+                << "  \"results\": [\n";
+
+            for (std::size_t i = 0; i < results.size(); i++)
+            {
+                char _ns[32];
+                std::snprintf(_ns, sizeof(_ns), "%.3f", results[i].nsPerSample);
+                _out << "    { \"group\": \"" << results[i].group << "\", \"name\": \"" << results[i].name
+                    << "\", \"nsPerSample\": " << _ns << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+
+            _out << "  ]\n}\n";
+            return _out.str();
+        }
+
+    private:
+        std::vector<Sample> m_Input;
+        std::vector<Sample> m_Block;
+
+        template<class Fun>
+        void Add(const std::string& group, const std::string& name, Fun&& fun)
+        {
+            double _ns = Measure(options, fun);
+            results.push_back({ group, name, _ns });
+            std::fprintf(stderr, "%-10s %-32s %10.2f ns/sample\n", group.c_str(), name.c_str(), _ns);
+        }
+    };
+
+    // Default voice rendered through the type-erased chain
+    template<class Parent>
+    struct ErasedVoice : MyVoice<Parent>
+    {
+        using MyVoice<Parent>::MyVoice;
+        void Render(std::size_t samples, int channels) override { Engine::VoiceBase::Render(samples, channels); }
+    };
+
+    void Usage()
+    {
+        std::cout
+            << "usage: synthmakr-bench [options]\n"
+            << "  -o <file>      write json results to file, stdout when omitted\n"
+            << "  -r <rate>      sample rate (default: 44100)\n"
+            << "  -c <channels>  channel count (default: 2)\n"
+            << "  -b <frames>    block size (default: 512)\n"
+            << "  -t <seconds>   time measured per round (default: 0.1)\n"
+            << "  -v <voices>    maximum voice count in the polyphony sweep (default: 256)\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options _options;
+    std::string _output;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string _arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string _value = argv[++i];
+        if (_arg == "-o") _output = _value;
+        else if (_arg == "-r") _options.sampleRate = std::stod(_value);
+        else if (_arg == "-c") _options.channels = std::stoi(_value);
+        else if (_arg == "-b") _options.blockSize = std::stoi(_value);
+        else if (_arg == "-t") _options.time = std::stod(_value);
+        else if (_arg == "-v") _options.maxVoices = std::stoi(_value);
+        else return Usage(), 1;
+    }
+
+    Bench _bench{ _options };
+    auto _prepare = [&](auto& p) { p.Prepare(_options.sampleRate, _options.blockSize, _options.channels); };
+
+    // Modules
+    for (int oversample : { 1, 2, 4, 8 })
+    {
+        Oscillator _osc{ { .oversample = oversample } };
+        _bench.Module("Oscillator/oversample=" + std::to_string(oversample), _osc);
+    }
+
+    Oscillator _bandlimited{ { .bandlimited = true } };
+    _bench.Module("Oscillator/bandlimited", _bandlimited);
+
+    ADSR _adsr;
+    _adsr.Gate(true);
+    _bench.Module("ADSR", _adsr);
+
+    LPF _lpf;
+    _bench.Module("LPF", _lpf);
+
+    Chorus _chorus;
+    _bench.Module("Chorus", _chorus);
+
+    Delay _delay;
+    _bench.Module("Delay", _delay);
+
+    Gain _gain{ { .gain = -6 } };
+    _bench.Module("Gain", _gain);
+
+    // Chains, a single voice and the master chain of the default patch
+    MyPatch _patch;
+    _prepare(_patch);
+    Engine::VoiceBank _voice;
+    _prepare(_voice);
+    _voice.AddVoices<MyVoice<MyPatch>>(1, &_patch);
+    _voice.NotePress(60, 127);
+    _bench.voiceBytes.push_back({ "MyVoice", _voice.VoiceBytes() });
+    std::fprintf(stderr, "%-10s %-32s %10zu bytes\n", "memory", "MyVoice", _voice.VoiceBytes());
+    _bench.Render("chains", "MyVoice", [&](std::span<Sample> b, int c) { _voice.Process(b, c); });
+
+    Engine::VoiceBank _erased;
+    _prepare(_erased);
+    _erased.AddVoices<ErasedVoice<MyPatch>>(1, &_patch);
+    _erased.NotePress(60, 127);
+    _bench.Render("chains", "MyVoice/erased", [&](std::span<Sample> b, int c) { _erased.Process(b, c); });
+
+    // Voice modulation at different control rates
+    for (int rate : { 1, 8, 16, 64 })
+    {
+        Module::CONTROL_RATE = rate;
+        _bench.Render("chains", "MyVoice/control=" + std::to_string(rate), [&](std::span<Sample> b, int c) { _voice.Process(b, c); });
+
+        // The chain is called every frame, so its dispatch isn't hidden by the block
+        if (rate == 1)
+            _bench.Render("chains", "MyVoice/erased/control=1", [&](std::span<Sample> b, int c) { _erased.Process(b, c); });
+    }
+    Module::CONTROL_RATE = 32;
+
+    ChainFun _master = _patch.Chain();
+    _bench.Render("chains", "MyPatch/master", [&](std::span<Sample> b, int c) { _patch.Mod(); _master(b, c); });
+
+    // Routing graph of 10 layers that split into 4 gains and sum them again, 50 nodes,
+    // against the same gains in a chain
+    std::vector<std::unique_ptr<Gain>> _gains;
+    Graph _graph;
+    Graph::Node _layer = _graph.In();
+    ChainFun _series;
+    for (int i = 0; i < 10; i++)
+    {
+        Graph::Node _sum = _graph.Sum({});
+        for (int j = 0; j < 4; j++)
+        {
+            Gain& _gain = *_gains.emplace_back(std::make_unique<Gain>(Gain::Settings{ .gain = -12 }));
+            _graph.Send(_graph.Add(_gain, { _layer }), _sum);
+            _series = _series ? ChainFun{ std::move(_series) >> _gain } : ChainFun{ ModuleStage<Gain>{ _gain } };
+        }
+        _layer = _sum;
+    }
+    _graph.Output(_layer);
+    _prepare(_graph);
+    std::fprintf(stderr, "%-10s %-32s %10d buffers\n", "memory", "graph/50", _graph.Buffers());
+    _bench.graphBuffers = _graph.Buffers();
+    _bench.Render("chains", "graph/50", [&](std::span<Sample> b, int c) { _graph.ProcessBlock(b, c); });
+    _bench.Render("chains", "graph/50/series", [&](std::span<Sample> b, int c) { _series(b, c); });
+
+    // Polyphony
+    for (int voices = 1; voices <= _options.maxVoices; voices *= 2)
+    {
+        Engine::VoiceBank _bank;
+        _prepare(_bank);
+        _bank.AddVoices<MyVoice<MyPatch>>(voices, &_patch);
+        for (int i = 0; i < voices; i++)
+            _bank.NotePress(36 + i % 48, 127);
+
+        _bench.Render("voices", std::to_string(voices), [&](std::span<Sample> b, int c) { _bank.Process(b, c); });
+    }
+
+    // Polyphony on all cores
+    int _threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    for (int threads = 2; threads <= _threads; threads *= 2)
+    {
+        Engine::VoiceBank _bank;
+        _bank.Threads(threads);
+        _prepare(_bank);
+        _bank.AddVoices<MyVoice<MyPatch>>(_options.maxVoices, &_patch);
+        for (int i = 0; i < _options.maxVoices; i++)
+            _bank.NotePress(36 + i % 48, 127);
+
+        _bench.Render("threads", std::to_string(threads) + "/" + std::to_string(_options.maxVoices), 
+            [&](std::span<Sample> b, int c) { _bank.Process(b, c); });
+    }
+
+    // Polyphony with the voices in simd lanes, for every width the cpu supports
+    for (int lanes = 4; lanes <= Simd::Lanes(); lanes *= 2)
+    {
+        for (int voices = 1; voices <= _options.maxVoices; voices *= 2)
+        {
+            SimdVoices _simd{ { .voices = voices, .lanes = lanes } };
+            _prepare(_simd);
+            for (int i = 0; i < voices; i++)
+                _simd.NotePress(36 + i % 48, 127);
+
+            _bench.Render("simd" + std::to_string(lanes), std::to_string(voices), [&](std::span<Sample> b, int c) { _simd.ProcessBlock(b, c); });
+        }
+    }
+
+    // Voice allocation with every voice playing, one press and release per frame
+    std::pair<const char*, VoiceAllocator::Policy> _policies[]{
+        { "oldest", VoiceAllocator::Oldest }, { "quietest", VoiceAllocator::Quietest },
+        { "samenote", VoiceAllocator::SameNote }, { "releasing", VoiceAllocator::ReleasingFirst },
+    };
+
+    for (auto& [name, policy] : _policies)
+    {
+        VoiceAllocator _allocator{ { .policy = policy } };
+        _allocator.Voices(_options.maxVoices);
+        std::vector<float> _levels(_options.maxVoices);
+        for (int i = 0; i < _options.maxVoices; i++)
+            _levels[_allocator.Press(i % 128, [](int) { return 0.f; })] = i % 7;
+
+        int _note = 0;
+        _bench.Render("allocator", std::string{ name } + "/" + std::to_string(_options.maxVoices), [&](std::span<Sample> b, int c) {
+            for (std::size_t i = 0; i < b.size() / c; i++, _note++)
+            {
+                _allocator.Release((_note + 64) % 128, [](int) {});
+                _allocator.Press(_note % 128, [&](int v) { return _levels[v]; });
+            }
+        });
+    }
+
+    if (_output.empty())
+        std::cout << _bench.Json();
+    else
+        std::ofstream{ _output } << _bench.Json();
+
+    return 0;
+}
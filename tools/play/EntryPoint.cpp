@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Backend.hpp"
+#include "MidiFile.hpp"
+#include "Patches.hpp"
+#include "Render.hpp"
+
+namespace
+{
+    void Usage()
+    {
+        std::string _backends;
+        for (auto& i : Backend::Names())
+            _backends += (_backends.empty() ? "" : ", ") + i;
+
+        std::cout
+            << "usage: synthmakr-play [options]\n"
+            << "  -p <patch>     patch to play (default: default)\n"
+            << "  -a <backend>   audio backend: " << _backends << " (default: " << Backend::Names().front() << ")\n"
+            << "  -d <device>    device of the backend, see -l (default: the default device)\n"
+            << "  -l <backend>   list the devices of a backend\n"
+            << "  -e <file>      note events, a midi file or lines of \"<time> <note> <velocity> <duration>\"\n"
+            << "  -r <rate>      sample rate (default: 48000)\n"
+            << "  -c <channels>  channel count (default: 2)\n"
+            << "  -b <frames>    buffer size (default: the size of the jack server, 256 otherwise)\n"
+            << "  -n <periods>   buffers queued in the device (default: 2)\n"
+            << "  -t <seconds>   tail after the last event (default: 2)\n"
+            << "  -j <threads>   threads rendering voices (default: 1)\n"
+            << "  -i <0|1>       play notes from the midi input of the backend (default: 1)\n"
+            << "  -m <file>      write the performance monitor stats as json, with module time\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string _patch = "default", _backend = Backend::Names().front(), _events, _monitor;
+    Backend::Settings _settings;
+    double _tail = 2;
+    int _threads = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string _arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string _value = argv[++i];
+        if (_arg == "-p") _patch = _value;
+        else if (_arg == "-a") _backend = _value;
+        else if (_arg == "-d") _settings.device = _value;
+        else if (_arg == "-e") _events = _value;
+        else if (_arg == "-r") _settings.sampleRate = std::stod(_value);
+        else if (_arg == "-c") _settings.channels = std::stoi(_value);
+        else if (_arg == "-b") _settings.bufferSize = std::stoi(_value);
+        else if (_arg == "-n") _settings.periods = std::stoi(_value);
+        else if (_arg == "-t") _tail = std::stod(_value);
+        else if (_arg == "-j") _threads = std::stoi(_value);
+        else if (_arg == "-i") _settings.midi = _value != "0";
+        else if (_arg == "-m") _monitor = _value;
+        else if (_arg == "-l")
+        {
+            auto _list = Backend::Create(_value, _settings);
+            if (!_list)
+                return std::cerr << "unknown backend: " << _value << "\n", 1;
+
+            for (auto& j : _list->Devices())
+                std::cout << (j.id.empty() ? "\"\"" : j.id) << "  " << j.name << "\n";
+            return 0;
+        }
+        else return Usage(), 1;
+    }
+
+    if (!patches.contains(_patch))
+    {
+        std::cerr << "unknown patch: " << _patch << "\n";
+        return 1;
+    }
+
+    auto _audio = Backend::Create(_backend, _settings);
+    if (!_audio)
+    {
+        std::cerr << "unknown backend: " << _backend << "\n";
+        return 1;
+    }
+
+    // Midi files are read while playing, frames are at the rate of the settings
+    Renderer _renderer{ { .sampleRate = _settings.sampleRate } };
+    Renderer::Source _source = _renderer.Events(DefaultEvents());
+    MidiFile _midi;
+    if (!_events.empty() && _midi.Open(_events, _settings.sampleRate))
+        _source = [&](Engine::Event& e) { return _midi.Next(e); };
+    else if (!_events.empty())
+    {
+        std::ifstream _file{ _events };
+        if (!_file)
+        {
+            std::cerr << "can't open events: " << _events << "\n";
+            return 1;
+        }
+        _source = _renderer.Events(ParseEvents(_file));
+    }
+
+    auto _engine = patches[_patch]();
+    _engine->Threads(_threads);
+    Monitor::TimeModules(!_monitor.empty());
+
+    if (!_audio->Start(*_engine))
+    {
+        std::cerr << "can't open " << _backend << " device: " << (_settings.device.empty() ? "default" : _settings.device) << "\n";
+        return 1;
+    }
+
+    auto& _format = _audio->Format();
+    std::printf("playing on %s, %d frames x %d periods at %.0f Hz\n", _backend.c_str(), _format.bufferSize, _format.periods, _format.sampleRate);
+
+    // Events are sent when they're due, like notes from a keyboard
+    using Clock = std::chrono::steady_clock;
+    auto _start = Clock::now();
+    auto _at = [&](double seconds) { return _start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{ seconds }); };
+    double _last = 0;
+    for (Engine::Event _event; _source(_event);)
+    {
+        _last = _event.frame / _settings.sampleRate;
+        std::this_thread::sleep_until(_at(_last));
+        _event.frame = -1;
+        _engine->Send(_event);
+    }
+
+    std::this_thread::sleep_until(_at(_last + _tail));
+    _audio->Stop();
+
+    auto _stats = _engine->Stats();
+    std::printf("played %.2f s, %llu xruns, load %.1f%% average, %.1f%% peak\n",
+        std::chrono::duration<double>(Clock::now() - _start).count(),
+        static_cast<unsigned long long>(_audio->Xruns()), _stats.average, _stats.peak);
+
+    if (!_monitor.empty() && !(std::ofstream{ _monitor } << Monitor::Json(_stats)))
+    {
+        std::cerr << "can't write monitor stats: " << _monitor << "\n";
+        return 1;
+    }
+
+    return 0;
+}
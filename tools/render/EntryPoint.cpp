@@ -0,0 +1,162 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "MidiFile.hpp"
+#include "Patches.hpp"
+#include "Render.hpp"
+
+namespace
+{
+    void Usage()
+    {
+        std::cout
+            << "usage: synthmakr-render [options]\n"
+            << "  -p <patch>     patch to render (default: default)\n"
+            << "  -e <file>      note events, a midi file or lines of \"<time> <note> <velocity> <duration>\"\n"
+            << "  -o <file>      output wav file, written while rendering\n"
+            << "  -r <rate>      sample rate (default: 44100)\n"
+            << "  -c <channels>  channel count (default: 2)\n"
+            << "  -b <frames>    block size (default: 512)\n"
+            << "  -t <seconds>   tail after the last event (default: 2)\n"
+            << "  -j <threads>   threads rendering voices (default: 1)\n"
+            << "  -s <policy>    voice stealing: oldest, quietest, samenote, releasing (default: releasing)\n"
+            << "  -m <file>      write the performance monitor stats as json, with module time\n"
+            << "  -T <file>      write a chrome trace of the render, for Perfetto\n"
+            << "  -a <action>    real-time violations with SYNTHMAKR_RTSAN: record, abort (default: record)\n";
+    }
+
+    const std::map<std::string, VoiceAllocator::Policy> policies{
+        { "oldest", VoiceAllocator::Oldest },
+        { "quietest", VoiceAllocator::Quietest },
+        { "samenote", VoiceAllocator::SameNote },
+        { "releasing", VoiceAllocator::ReleasingFirst },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    std::string _patch = "default", _events, _output, _monitor, _trace;
+    Renderer::Settings _settings;
+    int _threads = 1;
+    std::string _stealing = "releasing";
+    std::string _violation = "record";
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string _arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string _value = argv[++i];
+        if (_arg == "-p") _patch = _value;
+        else if (_arg == "-e") _events = _value;
+        else if (_arg == "-o") _output = _value;
+        else if (_arg == "-r") _settings.sampleRate = std::stod(_value);
+        else if (_arg == "-c") _settings.channels = std::stoi(_value);
+        else if (_arg == "-b") _settings.blockSize = std::stoi(_value);
+        else if (_arg == "-t") _settings.tail = std::stod(_value);
+        else if (_arg == "-j") _threads = std::stoi(_value);
+        else if (_arg == "-s") _stealing = _value;
+        else if (_arg == "-m") _monitor = _value;
+        else if (_arg == "-T") _trace = _value;
+        else if (_arg == "-a") _violation = _value;
+        else return Usage(), 1;
+    }
+
+    if (!patches.contains(_patch))
+    {
+        std::cerr << "unknown patch: " << _patch << "\n";
+        return 1;
+    }
+
+    if (!policies.contains(_stealing))
+    {
+        std::cerr << "unknown stealing policy: " << _stealing << "\n";
+        return 1;
+    }
+
+    // Midi files are streamed while rendering, other files are note events
+    Renderer _renderer{ _settings };
+    Renderer::Source _source = _renderer.Events(DefaultEvents());
+    MidiFile _midi;
+    if (!_events.empty() && _midi.Open(_events, _settings.sampleRate))
+        _source = [&](Engine::Event& e) { return _midi.Next(e); };
+    else if (!_events.empty())
+    {
+        std::ifstream _file{ _events };
+        if (!_file)
+        {
+            std::cerr << "can't open events: " << _events << "\n";
+            return 1;
+        }
+        _source = _renderer.Events(ParseEvents(_file));
+    }
+
+    WavWriter _wav;
+    if (!_output.empty() && !_wav.Open(_output, _settings.channels, _settings.sampleRate))
+    {
+        std::cerr << "can't write output: " << _output << "\n";
+        return 1;
+    }
+
+    auto _engine = patches[_patch]();
+    _engine->Threads(_threads);
+    _engine->Stealing(policies.at(_stealing));
+
+    if (_violation != "record" && _violation != "abort")
+    {
+        std::cerr << "unknown violation action: " << _violation << "\n";
+        return 1;
+    }
+
+    Realtime::OnViolation(_violation == "abort" ? Realtime::Abort : Realtime::Record);
+    Monitor::TimeModules(!_monitor.empty());
+    Trace::Name("Render");
+    if (!_trace.empty())
+        Trace::Start();
+
+    bool _written = true;
+    auto _start = std::chrono::steady_clock::now();
+    auto _frames = _renderer.Render(*_engine, _source, [&](std::span<const Sample> block) {
+        if (!_output.empty())
+            _written = _wav.Write(block) && _written;
+    });
+    auto _end = std::chrono::steady_clock::now();
+    Trace::Stop();
+
+    double _seconds = _frames / _settings.sampleRate;
+    double _elapsed = std::chrono::duration<double>(_end - _start).count();
+    std::printf("rendered %.2f s in %.3f s, %.1fx real-time\n", _seconds, _elapsed, _seconds / _elapsed);
+
+    // Fails the render, so rendering every patch checks real-time safety
+    if (Realtime::Violations())
+    {
+        Realtime::Report();
+        std::cerr << Realtime::Violations() << " real-time violations\n";
+        return 2;
+    }
+
+    if (!_output.empty() && !(_wav.Close() && _written))
+    {
+        std::cerr << "can't write output: " << _output << "\n";
+        return 1;
+    }
+
+    if (!_monitor.empty() && !(std::ofstream{ _monitor } << Monitor::Json(_engine->Stats())))
+    {
+        std::cerr << "can't write monitor stats: " << _monitor << "\n";
+        return 1;
+    }
+
+    if (std::ofstream _file{ _trace }; !_trace.empty() && !Trace::Write(_file))
+    {
+        std::cerr << "can't write trace: " << _trace << "\n";
+        return 1;
+    }
+
+    return 0;
+}